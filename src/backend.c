@@ -0,0 +1,1102 @@
+//========================================================================
+// GLFWDIAG - A diagnostic tool for GLFW
+//------------------------------------------------------------------------
+// Copyright (c) 2013 elmindreda <elmindreda@glfw.org>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would
+//    be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not
+//    be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source
+//    distribution.
+//
+//========================================================================
+
+#include <GLFW/glfw3.h>
+
+#include <GL/glext.h>
+
+#include <string.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "backend.h"
+
+#if GLFW_VERSION_MAJOR > 3 || GLFW_VERSION_MINOR >= 3
+ #define HAVE_CONTENT_SCALE
+#endif
+
+#define CAPTURE_HEADER          "GLFWDIAG capture 1"
+#define CAPTURE_MIN_CAPACITY    256
+#define KEY_SIZE                256
+#define VALUE_SIZE              64
+// Six numbers of up to eleven characters, each with a leading space
+#define MODE_VALUE_SIZE         (6 * 12)
+#define MODE_MIN_LENGTH         12
+#define REPLAY_MAX_MONITORS     256
+#define REPLAY_MAX_ELEMENTS     4096
+
+typedef struct capture_entry
+{
+    char* key;
+    // NULL if the query returned NULL
+    char* value;
+    // Parsed form of the value, created on first replay
+    void* data;
+    int count;
+} capture_entry;
+
+static struct
+{
+    capture_entry* entries;
+    size_t count;
+    size_t capacity;
+} capture;
+
+static struct
+{
+    GLFWmonitor** monitors;
+    int monitorCount;
+} replay;
+
+static PFNGLGETSTRINGIPROC live_glGetStringi = NULL;
+
+// Heap allocations made by the capture and replay code, never reset
+static unsigned int allocations = 0;
+
+static void format_key(char* key, const char* format, ...)
+{
+    va_list vl;
+
+    va_start(vl, format);
+    if (vsnprintf(key, KEY_SIZE, format, vl) < 0)
+        key[0] = '\0';
+    va_end(vl);
+
+    key[KEY_SIZE - 1] = '\0';
+}
+
+static size_t hash_key(const char* key)
+{
+    // FNV-1a
+    size_t hash = 2166136261u;
+
+    while (*key)
+    {
+        hash ^= (unsigned char) *key++;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static capture_entry* find_entry(const char* key)
+{
+    size_t index;
+
+    if (!capture.capacity)
+        return NULL;
+
+    index = hash_key(key) & (capture.capacity - 1);
+
+    while (capture.entries[index].key)
+    {
+        if (strcmp(capture.entries[index].key, key) == 0)
+            return capture.entries + index;
+
+        index = (index + 1) & (capture.capacity - 1);
+    }
+
+    return NULL;
+}
+
+static int grow_capture(void)
+{
+    size_t i;
+    capture_entry* entries;
+    const size_t capacity = capture.capacity ? capture.capacity * 2
+                                             : CAPTURE_MIN_CAPACITY;
+
+    allocations++;
+    entries = calloc(capacity, sizeof(capture_entry));
+    if (!entries)
+        return 0;
+
+    for (i = 0;  i < capture.capacity;  i++)
+    {
+        size_t index;
+
+        if (!capture.entries[i].key)
+            continue;
+
+        index = hash_key(capture.entries[i].key) & (capacity - 1);
+        while (entries[index].key)
+            index = (index + 1) & (capacity - 1);
+
+        entries[index] = capture.entries[i];
+    }
+
+    free(capture.entries);
+    capture.entries = entries;
+    capture.capacity = capacity;
+    return 1;
+}
+
+static void set_entry(const char* key, const char* value)
+{
+    size_t index;
+    capture_entry* entry = find_entry(key);
+
+    if (!entry)
+    {
+        if ((capture.count + 1) * 2 > capture.capacity)
+        {
+            if (!grow_capture())
+                return;
+        }
+
+        index = hash_key(key) & (capture.capacity - 1);
+        while (capture.entries[index].key)
+            index = (index + 1) & (capture.capacity - 1);
+
+        entry = capture.entries + index;
+        allocations++;
+        entry->key = strdup(key);
+        if (!entry->key)
+            return;
+
+        capture.count++;
+    }
+
+    free(entry->value);
+    free(entry->data);
+
+    if (value)
+        allocations++;
+
+    entry->value = value ? strdup(value) : NULL;
+    entry->data = NULL;
+    entry->count = 0;
+}
+
+static void record_int(const char* key, int value)
+{
+    char buffer[VALUE_SIZE];
+    sprintf(buffer, "%i", value);
+    set_entry(key, buffer);
+}
+
+static void record_pair(const char* key, int first, int second)
+{
+    char buffer[VALUE_SIZE];
+    sprintf(buffer, "%i %i", first, second);
+    set_entry(key, buffer);
+}
+
+static void record_scale(const char* key, float xscale, float yscale)
+{
+    char buffer[VALUE_SIZE];
+    sprintf(buffer, "%g %g", xscale, yscale);
+    set_entry(key, buffer);
+}
+
+static void record_modes(const char* key, const GLFWvidmode* modes, int count)
+{
+    int i;
+    char* buffer;
+    size_t length;
+
+    if (!modes)
+    {
+        set_entry(key, NULL);
+        return;
+    }
+
+    allocations++;
+    buffer = malloc(VALUE_SIZE + MODE_VALUE_SIZE * count);
+    if (!buffer)
+        return;
+
+    length = sprintf(buffer, "%i", count);
+    for (i = 0;  i < count;  i++)
+    {
+        length += sprintf(buffer + length, " %i %i %i %i %i %i",
+                          modes[i].width, modes[i].height,
+                          modes[i].redBits, modes[i].greenBits, modes[i].blueBits,
+                          modes[i].refreshRate);
+    }
+
+    set_entry(key, buffer);
+    free(buffer);
+}
+
+static const char* replay_string(const char* key)
+{
+    const capture_entry* entry = find_entry(key);
+    if (!entry)
+        return NULL;
+
+    return entry->value;
+}
+
+// Returns a placeholder rather than NULL for keys missing from the capture
+//
+static const char* replay_name(const char* key)
+{
+    const capture_entry* entry = find_entry(key);
+    if (!entry)
+        return "unknown";
+
+    return entry->value;
+}
+
+static int replay_int(const char* key, int fallback)
+{
+    const char* value = replay_string(key);
+    if (!value)
+        return fallback;
+
+    return atoi(value);
+}
+
+static void replay_scale(const char* key, float* xscale, float* yscale)
+{
+    const char* value = replay_string(key);
+
+    *xscale = *yscale = 0.f;
+
+    if (value)
+        sscanf(value, "%f %f", xscale, yscale);
+}
+
+static void replay_pair(const char* key, int* first, int* second)
+{
+    const char* value = replay_string(key);
+
+    *first = *second = 0;
+
+    if (value)
+        sscanf(value, "%i %i", first, second);
+}
+
+static const GLFWvidmode* replay_modes(const char* key, int* count)
+{
+    capture_entry* entry = find_entry(key);
+
+    *count = 0;
+
+    if (!entry || !entry->value)
+        return NULL;
+
+    if (!entry->data)
+    {
+        int i, modeCount;
+        char* end;
+        GLFWvidmode* modes;
+        const char* value = entry->value;
+
+        // Reject counts the value is too short to hold before allocating
+        modeCount = (int) strtol(value, &end, 10);
+        if (modeCount < 0 || end == value ||
+            (size_t) modeCount > strlen(end) / MODE_MIN_LENGTH)
+        {
+            return NULL;
+        }
+
+        allocations++;
+        modes = calloc(modeCount ? modeCount : 1, sizeof(GLFWvidmode));
+        if (!modes)
+            return NULL;
+
+        for (i = 0;  i < modeCount;  i++)
+        {
+            modes[i].width = (int) strtol(end, &end, 10);
+            modes[i].height = (int) strtol(end, &end, 10);
+            modes[i].redBits = (int) strtol(end, &end, 10);
+            modes[i].greenBits = (int) strtol(end, &end, 10);
+            modes[i].blueBits = (int) strtol(end, &end, 10);
+            modes[i].refreshRate = (int) strtol(end, &end, 10);
+        }
+
+        entry->data = modes;
+        entry->count = modeCount;
+    }
+
+    *count = entry->count;
+    return entry->data;
+}
+
+// Returns a zeroed array with the recorded number of elements
+//
+static const void* replay_array(const char* key, size_t size, int* count)
+{
+    capture_entry* entry = find_entry(key);
+
+    *count = 0;
+
+    if (!entry || !entry->value)
+        return NULL;
+
+    if (!entry->data)
+    {
+        const int elementCount = atoi(entry->value);
+        if (elementCount < 0 || elementCount > REPLAY_MAX_ELEMENTS)
+            return NULL;
+
+        allocations++;
+        entry->data = calloc(elementCount ? elementCount : 1, size);
+        if (!entry->data)
+            return NULL;
+
+        entry->count = elementCount;
+    }
+
+    *count = entry->count;
+    return entry->data;
+}
+
+static int get_monitor_index(GLFWmonitor* monitor)
+{
+    int i, count;
+    GLFWmonitor** monitors = glfwGetMonitors(&count);
+
+    for (i = 0;  i < count;  i++)
+    {
+        if (monitors[i] == monitor)
+            return i;
+    }
+
+    return -1;
+}
+
+// Replayed monitor handles are their index plus one
+//
+static GLFWmonitor* get_replay_monitor(int index)
+{
+    return (GLFWmonitor*) (size_t) (index + 1);
+}
+
+static int get_replay_monitor_index(GLFWmonitor* monitor)
+{
+    return (int) (size_t) monitor - 1;
+}
+
+static char* escape_string(char* target, const char* source)
+{
+    for (;  *source;  source++)
+    {
+        switch (*source)
+        {
+            case '\\':
+                *target++ = '\\';
+                *target++ = '\\';
+                break;
+            case '\t':
+                *target++ = '\\';
+                *target++ = 't';
+                break;
+            case '\n':
+                *target++ = '\\';
+                *target++ = 'n';
+                break;
+            case '\r':
+                *target++ = '\\';
+                *target++ = 'r';
+                break;
+            default:
+                *target++ = *source;
+                break;
+        }
+    }
+
+    return target;
+}
+
+static char* unescape_string(const char* source, size_t length)
+{
+    size_t i;
+    char* target = malloc(length + 1);
+    char* start = target;
+
+    allocations++;
+
+    if (!target)
+        return NULL;
+
+    for (i = 0;  i < length;  i++)
+    {
+        if (source[i] == '\\' && i + 1 < length)
+        {
+            i++;
+
+            if (source[i] == 't')
+                *target++ = '\t';
+            else if (source[i] == 'n')
+                *target++ = '\n';
+            else if (source[i] == 'r')
+                *target++ = '\r';
+            else
+                *target++ = source[i];
+        }
+        else
+            *target++ = source[i];
+    }
+
+    *target = '\0';
+    return start;
+}
+
+static void live_get_monitor_content_scale(GLFWmonitor* monitor, float* xscale, float* yscale)
+{
+#if defined(HAVE_CONTENT_SCALE)
+    glfwGetMonitorContentScale(monitor, xscale, yscale);
+#else
+    // Content scale was added in GLFW 3.3
+    *xscale = *yscale = 0.f;
+#endif
+}
+
+static const GLubyte* live_get_string(GLenum name)
+{
+    return glGetString(name);
+}
+
+static GLint live_get_integer(GLenum name)
+{
+    GLint value = 0;
+    glGetIntegerv(name, &value);
+    return value;
+}
+
+static int live_load_stringi(void)
+{
+    live_glGetStringi = (PFNGLGETSTRINGIPROC) glfwGetProcAddress("glGetStringi");
+    return live_glGetStringi != NULL;
+}
+
+static const GLubyte* live_get_stringi(GLenum name, GLuint index)
+{
+    return live_glGetStringi(name, index);
+}
+
+static const char* record_get_version_string(void)
+{
+    const char* version = glfwGetVersionString();
+    set_entry(CAPTURE_VERSION, version);
+    return version;
+}
+
+static GLFWmonitor** record_get_monitors(int* count)
+{
+    GLFWmonitor** monitors = glfwGetMonitors(count);
+    record_int(CAPTURE_MONITORS, *count);
+    return monitors;
+}
+
+static GLFWmonitor* record_get_primary_monitor(void)
+{
+    GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+    record_int(CAPTURE_PRIMARY, get_monitor_index(monitor));
+    return monitor;
+}
+
+static const char* record_get_monitor_name(GLFWmonitor* monitor)
+{
+    char key[KEY_SIZE];
+    const char* name = glfwGetMonitorName(monitor);
+
+    format_key(key, CAPTURE_MONITOR_NAME, get_monitor_index(monitor));
+    set_entry(key, name);
+    return name;
+}
+
+static void record_get_monitor_pos(GLFWmonitor* monitor, int* xpos, int* ypos)
+{
+    char key[KEY_SIZE];
+
+    glfwGetMonitorPos(monitor, xpos, ypos);
+
+    format_key(key, CAPTURE_MONITOR_POS, get_monitor_index(monitor));
+    record_pair(key, *xpos, *ypos);
+}
+
+static void record_get_monitor_physical_size(GLFWmonitor* monitor, int* width, int* height)
+{
+    char key[KEY_SIZE];
+
+    glfwGetMonitorPhysicalSize(monitor, width, height);
+
+    format_key(key, CAPTURE_MONITOR_SIZE, get_monitor_index(monitor));
+    record_pair(key, *width, *height);
+}
+
+static void record_get_monitor_content_scale(GLFWmonitor* monitor, float* xscale, float* yscale)
+{
+    char key[KEY_SIZE];
+
+    live_get_monitor_content_scale(monitor, xscale, yscale);
+
+    format_key(key, CAPTURE_MONITOR_SCALE, get_monitor_index(monitor));
+    record_scale(key, *xscale, *yscale);
+}
+
+static const GLFWvidmode* record_get_video_mode(GLFWmonitor* monitor)
+{
+    char key[KEY_SIZE];
+    const GLFWvidmode* mode = glfwGetVideoMode(monitor);
+
+    format_key(key, CAPTURE_MONITOR_MODE, get_monitor_index(monitor));
+    record_modes(key, mode, 1);
+    return mode;
+}
+
+static const GLFWvidmode* record_get_video_modes(GLFWmonitor* monitor, int* count)
+{
+    char key[KEY_SIZE];
+    const GLFWvidmode* modes = glfwGetVideoModes(monitor, count);
+
+    format_key(key, CAPTURE_MONITOR_MODES, get_monitor_index(monitor));
+    record_modes(key, modes, *count);
+    return modes;
+}
+
+static int record_joystick_present(int joy)
+{
+    char key[KEY_SIZE];
+    const int present = glfwJoystickPresent(joy);
+
+    format_key(key, CAPTURE_JOYSTICK_PRESENT, joy);
+    record_int(key, present);
+    return present;
+}
+
+static const char* record_get_joystick_name(int joy)
+{
+    char key[KEY_SIZE];
+    const char* name = glfwGetJoystickName(joy);
+
+    format_key(key, CAPTURE_JOYSTICK_NAME, joy);
+    set_entry(key, name);
+    return name;
+}
+
+static const float* record_get_joystick_axes(int joy, int* count)
+{
+    char key[KEY_SIZE];
+    const float* axes = glfwGetJoystickAxes(joy, count);
+
+    format_key(key, CAPTURE_JOYSTICK_AXES, joy);
+    if (axes)
+        record_int(key, *count);
+    else
+        set_entry(key, NULL);
+
+    return axes;
+}
+
+static const unsigned char* record_get_joystick_buttons(int joy, int* count)
+{
+    char key[KEY_SIZE];
+    const unsigned char* buttons = glfwGetJoystickButtons(joy, count);
+
+    format_key(key, CAPTURE_JOYSTICK_BUTTONS, joy);
+    if (buttons)
+        record_int(key, *count);
+    else
+        set_entry(key, NULL);
+
+    return buttons;
+}
+
+static GLFWwindow* record_get_current_context(void)
+{
+    GLFWwindow* window = glfwGetCurrentContext();
+    record_int(CAPTURE_CONTEXT, window != NULL);
+    return window;
+}
+
+static int record_get_window_attrib(GLFWwindow* window, int attrib)
+{
+    char key[KEY_SIZE];
+    const int value = glfwGetWindowAttrib(window, attrib);
+
+    format_key(key, CAPTURE_ATTRIB, attrib);
+    record_int(key, value);
+    return value;
+}
+
+static int record_extension_supported(const char* extension)
+{
+    char key[KEY_SIZE];
+    const int supported = glfwExtensionSupported(extension);
+
+    format_key(key, CAPTURE_EXTENSION, extension);
+    record_int(key, supported);
+    return supported;
+}
+
+static const GLubyte* record_get_string(GLenum name)
+{
+    char key[KEY_SIZE];
+    const GLubyte* value = glGetString(name);
+
+    format_key(key, CAPTURE_STRING, name);
+    set_entry(key, (const char*) value);
+    return value;
+}
+
+static GLint record_get_integer(GLenum name)
+{
+    char key[KEY_SIZE];
+    const GLint value = live_get_integer(name);
+
+    format_key(key, CAPTURE_INTEGER, name);
+    record_int(key, value);
+    return value;
+}
+
+static int record_load_stringi(void)
+{
+    const int available = live_load_stringi();
+    record_int(CAPTURE_STRINGI_LOADED, available);
+    return available;
+}
+
+static const GLubyte* record_get_stringi(GLenum name, GLuint index)
+{
+    char key[KEY_SIZE];
+    const GLubyte* value = live_glGetStringi(name, index);
+
+    format_key(key, CAPTURE_STRINGI, name, index);
+    set_entry(key, (const char*) value);
+    return value;
+}
+
+static const char* replay_get_version_string(void)
+{
+    return replay_name(CAPTURE_VERSION);
+}
+
+static GLFWmonitor** replay_get_monitors(int* count)
+{
+    int i;
+
+    *count = replay_int(CAPTURE_MONITORS, 0);
+    if (*count <= 0 || *count > REPLAY_MAX_MONITORS)
+    {
+        *count = 0;
+        return NULL;
+    }
+
+    if (*count > replay.monitorCount)
+    {
+        GLFWmonitor** monitors;
+
+        allocations++;
+        monitors = realloc(replay.monitors, sizeof(GLFWmonitor*) * *count);
+        if (!monitors)
+        {
+            *count = 0;
+            return NULL;
+        }
+
+        replay.monitors = monitors;
+        replay.monitorCount = *count;
+
+        for (i = 0;  i < *count;  i++)
+            replay.monitors[i] = get_replay_monitor(i);
+    }
+
+    return replay.monitors;
+}
+
+static GLFWmonitor* replay_get_primary_monitor(void)
+{
+    const int index = replay_int(CAPTURE_PRIMARY, -1);
+    if (index < 0)
+        return NULL;
+
+    return get_replay_monitor(index);
+}
+
+static const char* replay_get_monitor_name(GLFWmonitor* monitor)
+{
+    char key[KEY_SIZE];
+    format_key(key, CAPTURE_MONITOR_NAME, get_replay_monitor_index(monitor));
+    return replay_name(key);
+}
+
+static void replay_get_monitor_pos(GLFWmonitor* monitor, int* xpos, int* ypos)
+{
+    char key[KEY_SIZE];
+    format_key(key, CAPTURE_MONITOR_POS, get_replay_monitor_index(monitor));
+    replay_pair(key, xpos, ypos);
+}
+
+static void replay_get_monitor_physical_size(GLFWmonitor* monitor, int* width, int* height)
+{
+    char key[KEY_SIZE];
+    format_key(key, CAPTURE_MONITOR_SIZE, get_replay_monitor_index(monitor));
+    replay_pair(key, width, height);
+}
+
+static void replay_get_monitor_content_scale(GLFWmonitor* monitor, float* xscale, float* yscale)
+{
+    char key[KEY_SIZE];
+    format_key(key, CAPTURE_MONITOR_SCALE, get_replay_monitor_index(monitor));
+    replay_scale(key, xscale, yscale);
+}
+
+static const GLFWvidmode* replay_get_video_mode(GLFWmonitor* monitor)
+{
+    int count;
+    const GLFWvidmode* mode;
+    char key[KEY_SIZE];
+
+    format_key(key, CAPTURE_MONITOR_MODE, get_replay_monitor_index(monitor));
+    mode = replay_modes(key, &count);
+    if (count != 1)
+        return NULL;
+
+    return mode;
+}
+
+static const GLFWvidmode* replay_get_video_modes(GLFWmonitor* monitor, int* count)
+{
+    char key[KEY_SIZE];
+    format_key(key, CAPTURE_MONITOR_MODES, get_replay_monitor_index(monitor));
+    return replay_modes(key, count);
+}
+
+static int replay_joystick_present(int joy)
+{
+    char key[KEY_SIZE];
+    format_key(key, CAPTURE_JOYSTICK_PRESENT, joy);
+    return replay_int(key, 0);
+}
+
+static const char* replay_get_joystick_name(int joy)
+{
+    char key[KEY_SIZE];
+    format_key(key, CAPTURE_JOYSTICK_NAME, joy);
+    return replay_name(key);
+}
+
+static const float* replay_get_joystick_axes(int joy, int* count)
+{
+    char key[KEY_SIZE];
+    format_key(key, CAPTURE_JOYSTICK_AXES, joy);
+    return replay_array(key, sizeof(float), count);
+}
+
+static const unsigned char* replay_get_joystick_buttons(int joy, int* count)
+{
+    char key[KEY_SIZE];
+    format_key(key, CAPTURE_JOYSTICK_BUTTONS, joy);
+    return replay_array(key, sizeof(unsigned char), count);
+}
+
+static GLFWwindow* replay_get_current_context(void)
+{
+    // The replayed context handle only needs to be non-NULL
+    if (!replay_int(CAPTURE_CONTEXT, 0))
+        return NULL;
+
+    return (GLFWwindow*) &replay;
+}
+
+static int replay_get_window_attrib(GLFWwindow* window, int attrib)
+{
+    char key[KEY_SIZE];
+    format_key(key, CAPTURE_ATTRIB, attrib);
+    return replay_int(key, 0);
+}
+
+static int replay_extension_supported(const char* extension)
+{
+    char key[KEY_SIZE];
+    format_key(key, CAPTURE_EXTENSION, extension);
+    return replay_int(key, 0);
+}
+
+static const GLubyte* replay_get_string(GLenum name)
+{
+    char key[KEY_SIZE];
+    format_key(key, CAPTURE_STRING, name);
+    return (const GLubyte*) replay_name(key);
+}
+
+static GLint replay_get_integer(GLenum name)
+{
+    int value;
+    char key[KEY_SIZE];
+
+    format_key(key, CAPTURE_INTEGER, name);
+    value = replay_int(key, 0);
+
+    // The extension count drives one lookup per extension, so a corrupt
+    // capture must not be able to make the report build run forever
+    // Every extension needs its own entry, so more than that is never real
+    if (name == GL_NUM_EXTENSIONS)
+    {
+        if (value < 0)
+            return 0;
+        if (value > REPLAY_MAX_ELEMENTS)
+            value = REPLAY_MAX_ELEMENTS;
+        if ((size_t) value > capture.count)
+            value = (int) capture.count;
+    }
+
+    return value;
+}
+
+static int replay_load_stringi(void)
+{
+    return replay_int(CAPTURE_STRINGI_LOADED, 0);
+}
+
+static const GLubyte* replay_get_stringi(GLenum name, GLuint index)
+{
+    char key[KEY_SIZE];
+    format_key(key, CAPTURE_STRINGI, name, index);
+    return (const GLubyte*) replay_string(key);
+}
+
+const diag_backend live_backend =
+{
+    glfwGetVersionString,
+    glfwGetMonitors,
+    glfwGetPrimaryMonitor,
+    glfwGetMonitorName,
+    glfwGetMonitorPos,
+    glfwGetMonitorPhysicalSize,
+    live_get_monitor_content_scale,
+    glfwGetVideoMode,
+    glfwGetVideoModes,
+    glfwJoystickPresent,
+    glfwGetJoystickName,
+    glfwGetJoystickAxes,
+    glfwGetJoystickButtons,
+    glfwGetCurrentContext,
+    glfwGetWindowAttrib,
+    glfwExtensionSupported,
+    live_get_string,
+    live_get_integer,
+    live_load_stringi,
+    live_get_stringi
+};
+
+const diag_backend record_backend =
+{
+    record_get_version_string,
+    record_get_monitors,
+    record_get_primary_monitor,
+    record_get_monitor_name,
+    record_get_monitor_pos,
+    record_get_monitor_physical_size,
+    record_get_monitor_content_scale,
+    record_get_video_mode,
+    record_get_video_modes,
+    record_joystick_present,
+    record_get_joystick_name,
+    record_get_joystick_axes,
+    record_get_joystick_buttons,
+    record_get_current_context,
+    record_get_window_attrib,
+    record_extension_supported,
+    record_get_string,
+    record_get_integer,
+    record_load_stringi,
+    record_get_stringi
+};
+
+const diag_backend replay_backend =
+{
+    replay_get_version_string,
+    replay_get_monitors,
+    replay_get_primary_monitor,
+    replay_get_monitor_name,
+    replay_get_monitor_pos,
+    replay_get_monitor_physical_size,
+    replay_get_monitor_content_scale,
+    replay_get_video_mode,
+    replay_get_video_modes,
+    replay_joystick_present,
+    replay_get_joystick_name,
+    replay_get_joystick_axes,
+    replay_get_joystick_buttons,
+    replay_get_current_context,
+    replay_get_window_attrib,
+    replay_extension_supported,
+    replay_get_string,
+    replay_get_integer,
+    replay_load_stringi,
+    replay_get_stringi
+};
+
+void clear_capture(void)
+{
+    size_t i;
+
+    for (i = 0;  i < capture.capacity;  i++)
+    {
+        free(capture.entries[i].key);
+        free(capture.entries[i].value);
+        free(capture.entries[i].data);
+    }
+
+    free(capture.entries);
+    memset(&capture, 0, sizeof(capture));
+
+    free(replay.monitors);
+    memset(&replay, 0, sizeof(replay));
+}
+
+void set_capture_value(const char* key, const char* value)
+{
+    set_entry(key, value);
+}
+
+unsigned int get_capture_allocations(void)
+{
+    return allocations;
+}
+
+int is_capture_empty(void)
+{
+    return capture.count == 0;
+}
+
+static int compare_entries(const void* first, const void* second)
+{
+    const capture_entry* a = *((const capture_entry**) first);
+    const capture_entry* b = *((const capture_entry**) second);
+
+    return strcmp(a->key, b->key);
+}
+
+char* serialize_capture(void)
+{
+    size_t i, size, count = 0;
+    char* text;
+    char* target;
+    const capture_entry** entries;
+
+    // Sorted by key so that captures of the same machine diff cleanly
+    allocations++;
+    entries = malloc(sizeof(capture_entry*) * (capture.count + 1));
+    if (!entries)
+        return NULL;
+
+    size = strlen(CAPTURE_HEADER) + 2;
+    for (i = 0;  i < capture.capacity;  i++)
+    {
+        const capture_entry* entry = capture.entries + i;
+        if (!entry->key)
+            continue;
+
+        entries[count++] = entry;
+
+        // Every character may need escaping, plus a tab and a newline
+        size += strlen(entry->key) * 2 + 2;
+        if (entry->value)
+            size += strlen(entry->value) * 2;
+    }
+
+    qsort(entries, count, sizeof(capture_entry*), compare_entries);
+
+    allocations++;
+    text = malloc(size + 1);
+    if (!text)
+    {
+        free(entries);
+        return NULL;
+    }
+
+    target = text;
+    strcpy(target, CAPTURE_HEADER "\n");
+    target += strlen(target);
+
+    for (i = 0;  i < count;  i++)
+    {
+        target = escape_string(target, entries[i]->key);
+
+        // A line without a tab records a NULL answer
+        if (entries[i]->value)
+        {
+            *target++ = '\t';
+            target = escape_string(target, entries[i]->value);
+        }
+
+        *target++ = '\n';
+    }
+
+    *target = '\0';
+
+    free(entries);
+    return text;
+}
+
+int parse_capture(const char* text)
+{
+    const size_t headerLength = strlen(CAPTURE_HEADER);
+
+    clear_capture();
+
+    if (strncmp(text, CAPTURE_HEADER, headerLength) != 0)
+        return 0;
+
+    text += headerLength;
+
+    while (*text)
+    {
+        char* key;
+        size_t lineLength, keyLength;
+
+        text += strspn(text, "\r\n");
+        if (!*text)
+            break;
+
+        lineLength = strcspn(text, "\r\n");
+        keyLength = strcspn(text, "\t\r\n");
+
+        key = unescape_string(text, keyLength);
+        if (!key)
+            return 0;
+
+        if (keyLength < lineLength)
+        {
+            char* value = unescape_string(text + keyLength + 1,
+                                          lineLength - keyLength - 1);
+            if (!value)
+            {
+                free(key);
+                return 0;
+            }
+
+            set_entry(key, value);
+            free(value);
+        }
+        else
+            set_entry(key, NULL);
+
+        free(key);
+        text += lineLength;
+    }
+
+    return 1;
+}
+
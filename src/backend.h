@@ -0,0 +1,90 @@
+//========================================================================
+// GLFWDIAG - A diagnostic tool for GLFW
+//------------------------------------------------------------------------
+// Copyright (c) 2013 elmindreda <elmindreda@glfw.org>
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would
+//    be appreciated but is not required.
+//
+// 2. Altered source versions must be plainly marked as such, and must not
+//    be misrepresented as being the original software.
+//
+// 3. This notice may not be removed or altered from any source
+//    distribution.
+//
+//========================================================================
+
+#include <GLFW/glfw3.h>
+
+// The queries used to build the report
+// The live backend forwards to GLFW and GL, the record backend does the same
+// and stores every answer in the capture, and the replay backend serves
+// answers from the capture without touching GLFW or GL
+//
+typedef struct diag_backend
+{
+    const char*         (*getVersionString)(void);
+    GLFWmonitor**       (*getMonitors)(int*);
+    GLFWmonitor*        (*getPrimaryMonitor)(void);
+    const char*         (*getMonitorName)(GLFWmonitor*);
+    void                (*getMonitorPos)(GLFWmonitor*, int*, int*);
+    void                (*getMonitorPhysicalSize)(GLFWmonitor*, int*, int*);
+    void                (*getMonitorContentScale)(GLFWmonitor*, float*, float*);
+    const GLFWvidmode*  (*getVideoMode)(GLFWmonitor*);
+    const GLFWvidmode*  (*getVideoModes)(GLFWmonitor*, int*);
+    int                 (*joystickPresent)(int);
+    const char*         (*getJoystickName)(int);
+    const float*        (*getJoystickAxes)(int, int*);
+    const unsigned char* (*getJoystickButtons)(int, int*);
+    GLFWwindow*         (*getCurrentContext)(void);
+    int                 (*getWindowAttrib)(GLFWwindow*, int);
+    int                 (*extensionSupported)(const char*);
+    const GLubyte*      (*getString)(GLenum);
+    GLint               (*getInteger)(GLenum);
+    int                 (*loadStringi)(void);
+    const GLubyte*      (*getStringi)(GLenum, GLuint);
+} diag_backend;
+
+// Capture keys, formatted with the arguments of the query
+#define CAPTURE_VERSION             "version"
+#define CAPTURE_MONITORS            "monitors"
+#define CAPTURE_PRIMARY             "primary"
+#define CAPTURE_MONITOR_NAME        "monitor %i name"
+#define CAPTURE_MONITOR_POS         "monitor %i pos"
+#define CAPTURE_MONITOR_SIZE        "monitor %i size"
+#define CAPTURE_MONITOR_SCALE       "monitor %i scale"
+#define CAPTURE_MONITOR_MODE        "monitor %i mode"
+#define CAPTURE_MONITOR_MODES       "monitor %i modes"
+#define CAPTURE_JOYSTICK_PRESENT    "joystick %i present"
+#define CAPTURE_JOYSTICK_NAME       "joystick %i name"
+#define CAPTURE_JOYSTICK_AXES       "joystick %i axes"
+#define CAPTURE_JOYSTICK_BUTTONS    "joystick %i buttons"
+#define CAPTURE_CONTEXT             "context"
+#define CAPTURE_ATTRIB              "attrib 0x%08x"
+#define CAPTURE_EXTENSION           "extension %s"
+#define CAPTURE_STRING              "string 0x%08x"
+#define CAPTURE_INTEGER             "integer 0x%08x"
+#define CAPTURE_STRINGI_LOADED      "stringi"
+#define CAPTURE_STRINGI             "stringi 0x%08x %u"
+
+extern const diag_backend live_backend;
+extern const diag_backend record_backend;
+extern const diag_backend replay_backend;
+
+extern void clear_capture(void);
+extern void set_capture_value(const char* key, const char* value);
+extern unsigned int get_capture_allocations(void);
+extern int is_capture_empty(void);
+extern char* serialize_capture(void);
+extern int parse_capture(const char* text);
+
@@ -28,12 +28,31 @@
 
 #include <GL/glext.h>
 
+#if GLFW_VERSION_MAJOR > 3 || GLFW_VERSION_MINOR >= 1
+ #define HAVE_EMPTY_EVENT
+ #include <tinycthread.h>
+#endif
+
+#if GLFW_VERSION_MAJOR > 3 || GLFW_VERSION_MINOR >= 2
+ #define HAVE_WINDOW_MONITOR
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define HAVE_SSE2
+ #define COMPARE_NAME "SSE2"
+ #include <emmintrin.h>
+#else
+ #define COMPARE_NAME "scalar"
+#endif
+
 #include <string.h>
 #include <stdarg.h>
+#include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
 
 #include "diag.h"
+#include "backend.h"
 
 #define API_OPENGL          "gl"
 #define API_OPENGL_ES       "es"
@@ -44,26 +63,197 @@
 #define STRATEGY_NAME_NONE  "none"
 #define STRATEGY_NAME_LOSE  "lose"
 
-static char* report = NULL;
+#define EVENT_WINDOW_POS    0
+#define EVENT_WINDOW_SIZE   1
+#define EVENT_FRAMEBUFFER   2
+#define EVENT_REFRESH       3
+#define EVENT_FOCUS         4
+#define EVENT_KEY           5
+#define EVENT_CHAR          6
+#define EVENT_MOUSE_BUTTON  7
+#define EVENT_CURSOR_POS    8
+#define EVENT_SCROLL        9
+#define EVENT_TYPE_COUNT    10
+
+#define EVENT_PHASE_IDLE    0
+#define EVENT_PHASE_MOVE    1
+#define EVENT_PHASE_RESIZE  2
+#define EVENT_PHASE_COUNT   3
+
+#define EVENT_ITERATIONS    500
+#define WAKEUP_ITERATIONS   200
+
+#define TRANSITION_RESIZE       0
+#define TRANSITION_FULLSCREEN   1
+#define TRANSITION_WINDOWED     2
+#define TRANSITION_TYPE_COUNT   3
+
+#define TRANSITION_SAMPLES  64
+#define RESIZE_CYCLES       32
+#define STABLE_TIMEOUT      2.0
+#define STALL_THRESHOLD     0.1
+
+#define WINDOWED_XPOS       100
+#define WINDOWED_YPOS       100
+#define WINDOWED_WIDTH      640
+#define WINDOWED_HEIGHT     480
+
+#define REPORT_MIN_CAPACITY 4096
+#define FORMAT_BUFFER_SIZE  1024
+#define FORMAT_MAX_SIZE     (16 * 1024 * 1024)
+
+#define REPLAY_ITERATIONS   10000
+
+#define GAMMA_SAMPLES       15
+
+#define READBACK_WIDTH      640
+#define READBACK_HEIGHT     480
+#define READBACK_FRAMES     120
+// Must share no factor with any ring size up to READBACK_MAX_BUFFERS, or a
+// buffer that stops being written would keep holding its expected pattern
+#define READBACK_PATTERNS   5
+#define READBACK_MAX_BUFFERS 4
+#define READBACK_TIMEOUT    1000000000
+
+#define SOAK_ITERATIONS     1000000
+#define SOAK_BLOCK_COUNT    10
+#define SOAK_MAX_MONITORS   4
+#define SOAK_MAX_MODES      64
+#define SOAK_MAX_EXTENSIONS 256
+#define SOAK_MEMORY_LIMIT   (8 * 1024 * 1024)
+#define SOAK_SLOWDOWN_LIMIT 2.0
+#define SOAK_GROWTH_LIMIT   (1024 * 1024)
+#define SOAK_ALLOCATION_LIMIT 16
+#define SOAK_HUGE_NAME_SIZE (128 * 1024)
+#define SOAK_PROGRESS_INTERVAL 1024
+
+typedef struct report_buffer
+{
+    char* text;
+    size_t length;
+    size_t capacity;
+    unsigned int allocations;
+    unsigned int formatAllocations;
+} report_buffer;
+
+static report_buffer report;
+
+static const diag_backend* backend = &live_backend;
+
+static const unsigned char readback_colors[READBACK_PATTERNS][3] =
+{
+    { 0xff, 0x40, 0x00 },
+    { 0x00, 0xc0, 0x80 },
+    { 0x20, 0x00, 0xff },
+    { 0x80, 0x80, 0x80 },
+    { 0xff, 0xff, 0x40 }
+};
+
+static struct
+{
+    PFNGLGENBUFFERSPROC GenBuffers;
+    PFNGLDELETEBUFFERSPROC DeleteBuffers;
+    PFNGLBINDBUFFERPROC BindBuffer;
+    PFNGLBUFFERDATAPROC BufferData;
+    PFNGLMAPBUFFERPROC MapBuffer;
+    PFNGLUNMAPBUFFERPROC UnmapBuffer;
+    PFNGLFENCESYNCPROC FenceSync;
+    PFNGLCLIENTWAITSYNCPROC ClientWaitSync;
+    PFNGLDELETESYNCPROC DeleteSync;
+    int width;
+    int height;
+    size_t size;
+    int bits[4];
+    unsigned char tolerance[4];
+    unsigned char* expected[READBACK_PATTERNS];
+    unsigned char* pixels;
+} readback;
+
+static struct
+{
+    unsigned int seed;
+    char* extensions;
+    size_t capacity;
+    char* hugeName;
+    unsigned int hugeLines;
+    unsigned int truncations;
+} soak;
+
+static struct
+{
+    unsigned short* values;
+    unsigned int capacity;
+} ramps;
+
+static int reserve_report(size_t size)
+{
+    char* text;
+    size_t capacity;
+
+    if (size <= report.capacity)
+        return 1;
+
+    capacity = report.capacity ? report.capacity : REPORT_MIN_CAPACITY;
+    while (capacity < size)
+        capacity *= 2;
+
+    text = realloc(report.text, capacity);
+    if (!text)
+        return 0;
+
+    report.text = text;
+    report.capacity = capacity;
+    report.allocations++;
+    return 1;
+}
+
+static void append_text(const char* text, size_t length)
+{
+    if (!reserve_report(report.length + length + 1))
+        return;
+
+    memcpy(report.text + report.length, text, length);
+    report.length += length;
+    report.text[report.length] = '\0';
+}
 
 static void append(const char* format, ...)
 {
     va_list vl;
-    char buffer[65536];
+    int length;
+    char buffer[FORMAT_BUFFER_SIZE];
+    char* text = buffer;
+    size_t size = sizeof(buffer);
+
+    // Some C runtimes return -1 rather than the required size on truncation,
+    // so grow until the result fits either way
+    for (;;)
+    {
+        va_start(vl, format);
+        length = vsnprintf(text, size, format, vl);
+        va_end(vl);
 
-    va_start(vl, format);
-    if (vsnprintf(buffer, sizeof(buffer), format, vl) < 0)
-        buffer[sizeof(buffer) - 1] = '\0';
-    va_end(vl);
+        if (length >= 0 && (size_t) length < size)
+            break;
 
-    if (report)
-    {
-        const size_t length = strlen(buffer) + strlen(report) + 1;
-        report = realloc(report, length);
-        strcat(report, buffer);
+        if (text != buffer)
+            free(text);
+
+        size = (length >= 0) ? (size_t) length + 1 : size * 2;
+        if (size > FORMAT_MAX_SIZE)
+            return;
+
+        text = malloc(size);
+        if (!text)
+            return;
+
+        report.formatAllocations++;
     }
-    else
-        report = strdup(buffer);
+
+    append_text(text, length);
+
+    if (text != buffer)
+        free(text);
 }
 
 static void append_separator(void)
@@ -92,54 +282,1278 @@ static const char* format_video_mode(const GLFWvidmode* mode)
     return buffer;
 }
 
-static const char* get_client_api_name(int api)
+static int get_dpi(int pixels, int millimeters)
 {
-    if (api == GLFW_OPENGL_API)
-        return "OpenGL";
-    else if (api == GLFW_OPENGL_ES_API)
-        return "OpenGL ES";
+    if (millimeters <= 0)
+        return 0;
 
-    return "Unknown API";
+    return (int) ((double) pixels * 25.4 / (double) millimeters + 0.5);
 }
 
-static const char* get_profile_name_gl(GLint mask)
+static struct
 {
-    if (mask & GL_CONTEXT_COMPATIBILITY_PROFILE_BIT)
-        return PROFILE_NAME_COMPAT;
-    if (mask & GL_CONTEXT_CORE_PROFILE_BIT)
-        return PROFILE_NAME_CORE;
+    unsigned int counts[EVENT_TYPE_COUNT];
+    double times[EVENT_TYPE_COUNT];
+    double mark;
+} events;
+
+static const char* event_type_names[EVENT_TYPE_COUNT] =
+{
+    "window position",
+    "window size",
+    "framebuffer size",
+    "window refresh",
+    "window focus",
+    "key",
+    "character",
+    "mouse button",
+    "cursor position",
+    "scroll"
+};
+
+static const char* event_phase_names[EVENT_PHASE_COUNT] =
+{
+    "idle",
+    "move",
+    "resize"
+};
+
+#if defined(HAVE_EMPTY_EVENT)
+static struct
+{
+    mtx_t lock;
+    cnd_t signal;
+    int posted;
+    int received;
+    double postTime;
+} wakeup;
+#endif
+
+// Attributes the time since GLFW was entered, or since the previous
+// callback returned, to the dispatch of this event
+//
+static void record_event(int type)
+{
+    events.times[type] += glfwGetTime() - events.mark;
+    events.counts[type]++;
+    events.mark = glfwGetTime();
+}
+
+static void window_pos_callback(GLFWwindow* window, int x, int y)
+{
+    record_event(EVENT_WINDOW_POS);
+}
+
+static void window_size_callback(GLFWwindow* window, int width, int height)
+{
+    record_event(EVENT_WINDOW_SIZE);
+}
+
+static void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    record_event(EVENT_FRAMEBUFFER);
+}
+
+static void window_refresh_callback(GLFWwindow* window)
+{
+    record_event(EVENT_REFRESH);
+}
+
+static void window_focus_callback(GLFWwindow* window, int focused)
+{
+    record_event(EVENT_FOCUS);
+}
+
+static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    record_event(EVENT_KEY);
+}
+
+static void char_callback(GLFWwindow* window, unsigned int codepoint)
+{
+    record_event(EVENT_CHAR);
+}
+
+static void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+    record_event(EVENT_MOUSE_BUTTON);
+}
+
+static void cursor_pos_callback(GLFWwindow* window, double x, double y)
+{
+    record_event(EVENT_CURSOR_POS);
+}
+
+static void scroll_callback(GLFWwindow* window, double x, double y)
+{
+    record_event(EVENT_SCROLL);
+}
+
+static unsigned int get_event_total(void)
+{
+    int i;
+    unsigned int total = 0;
+
+    for (i = 0;  i < EVENT_TYPE_COUNT;  i++)
+        total += events.counts[i];
+
+    return total;
+}
+
+static double run_event_phase(GLFWwindow* window, int phase, unsigned int* dispatched)
+{
+    int i;
+    double base, total = 0.0;
+    const unsigned int before = get_event_total();
+
+    // On some platforms the requests dispatch their events synchronously,
+    // so the request and the poll are timed together
+    for (i = 0;  i < EVENT_ITERATIONS;  i++)
+    {
+        base = events.mark = glfwGetTime();
+
+        if (phase == EVENT_PHASE_MOVE)
+            glfwSetWindowPos(window, 100 + (i & 1) * 16, 100);
+        else if (phase == EVENT_PHASE_RESIZE)
+            glfwSetWindowSize(window, 640 + (i & 1) * 16, 480);
+
+        events.mark = glfwGetTime();
+        glfwPollEvents();
+        total += glfwGetTime() - base;
+    }
+
+    *dispatched = get_event_total() - before;
+    return total;
+}
+
+#if defined(HAVE_EMPTY_EVENT)
+static int wakeup_thread_main(void* data)
+{
+    int i;
+    const struct timespec delay = { 0, 2000000 };
+
+    for (i = 0;  i < WAKEUP_ITERATIONS;  i++)
+    {
+        // Give the main thread time to block in glfwWaitEvents
+        thrd_sleep(&delay, NULL);
+
+        mtx_lock(&wakeup.lock);
+        while (wakeup.posted)
+            cnd_wait(&wakeup.signal, &wakeup.lock);
+
+        wakeup.posted = GL_TRUE;
+        wakeup.postTime = glfwGetTime();
+        mtx_unlock(&wakeup.lock);
+
+        glfwPostEmptyEvent();
+    }
+
+    return 0;
+}
+
+static void test_empty_event_latency(void)
+{
+    thrd_t thread;
+    double latency, total = 0.0, worst = 0.0;
+
+    memset(&wakeup, 0, sizeof(wakeup));
+
+    if (mtx_init(&wakeup.lock, mtx_plain) != thrd_success ||
+        cnd_init(&wakeup.signal) != thrd_success)
+    {
+        append("Failed to initialize wakeup synchronization\r\n");
+        return;
+    }
+
+    if (thrd_create(&thread, wakeup_thread_main, NULL) != thrd_success)
+    {
+        append("Failed to create wakeup thread\r\n");
+        cnd_destroy(&wakeup.signal);
+        mtx_destroy(&wakeup.lock);
+        return;
+    }
+
+    while (wakeup.received < WAKEUP_ITERATIONS)
+    {
+        glfwWaitEvents();
+
+        // Other events may also wake us, so only count posted ones
+        mtx_lock(&wakeup.lock);
+        if (wakeup.posted)
+        {
+            latency = glfwGetTime() - wakeup.postTime;
+            total += latency;
+            if (latency > worst)
+                worst = latency;
+
+            wakeup.posted = GL_FALSE;
+            wakeup.received++;
+            cnd_signal(&wakeup.signal);
+        }
+        mtx_unlock(&wakeup.lock);
+    }
+
+    thrd_join(thread, NULL);
+    cnd_destroy(&wakeup.signal);
+    mtx_destroy(&wakeup.lock);
+
+    append("Empty event wakeup latency: %0.3f ms average, %0.3f ms worst over %i posts\r\n",
+           total * 1000.0 / WAKEUP_ITERATIONS,
+           worst * 1000.0,
+           WAKEUP_ITERATIONS);
+}
+#endif
+
+static const int resize_sizes[][2] =
+{
+    { 800, 600 },
+    { 1024, 768 },
+    { 320, 240 },
+    { WINDOWED_WIDTH, WINDOWED_HEIGHT }
+};
+
+static const char* transition_type_names[TRANSITION_TYPE_COUNT] =
+{
+    "Window resize",
+    "Windowed to full screen",
+    "Full screen to windowed"
+};
+
+static struct
+{
+    double samples[TRANSITION_SAMPLES];
+    int count;
+    int timeouts;
+} transitions[TRANSITION_TYPE_COUNT];
+
+// Ratio of framebuffer to window size, measured when the test starts
+static double framebuffer_scale = 1.0;
+
+static int compare_doubles(const void* first, const void* second)
+{
+    const double a = *((const double*) first);
+    const double b = *((const double*) second);
+
+    if (a < b)
+        return -1;
+    if (a > b)
+        return 1;
+
+    return 0;
+}
+
+static void add_transition_sample(int type, double duration)
+{
+    if (duration < 0.0)
+        transitions[type].timeouts++;
+    else if (transitions[type].count < TRANSITION_SAMPLES)
+        transitions[type].samples[transitions[type].count++] = duration;
+}
+
+// Renders frames until one has been presented at the requested size
+// Returns the time since base or a negative value on timeout
+//
+static double wait_for_stable_frame(GLFWwindow* window,
+                                    int width, int height,
+                                    double base)
+{
+    // The window size may change synchronously with the request, so wait
+    // for the framebuffer instead
+    const int targetWidth = (int) (width * framebuffer_scale + 0.5);
+    const int targetHeight = (int) (height * framebuffer_scale + 0.5);
+
+    for (;;)
+    {
+        int currentWidth, currentHeight;
+
+        glfwPollEvents();
+        glfwGetFramebufferSize(window, &currentWidth, &currentHeight);
+
+        glViewport(0, 0, currentWidth, currentHeight);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glfwSwapBuffers(window);
+
+        if (currentWidth == targetWidth && currentHeight == targetHeight)
+        {
+            // Stop the clock only once a frame at the new size has completed
+            glFinish();
+            return glfwGetTime() - base;
+        }
+
+        if (glfwGetTime() - base > STABLE_TIMEOUT)
+            return -1.0;
+    }
+}
+
+// Moves the window to the specified monitor, or back to windowed mode if
+// the monitor is NULL
+// Without glfwSetWindowMonitor the window and its context are recreated
+//
+static GLFWwindow* set_window_monitor(GLFWwindow* window,
+                                      GLFWmonitor* monitor,
+                                      const GLFWvidmode* mode)
+{
+#if defined(HAVE_WINDOW_MONITOR)
+    if (monitor)
+    {
+        glfwSetWindowMonitor(window, monitor,
+                             0, 0, mode->width, mode->height,
+                             mode->refreshRate);
+    }
+    else
+    {
+        glfwSetWindowMonitor(window, NULL,
+                             WINDOWED_XPOS, WINDOWED_YPOS,
+                             WINDOWED_WIDTH, WINDOWED_HEIGHT,
+                             0);
+    }
+
+    return window;
+#else
+    glfwDestroyWindow(window);
+
+    if (monitor)
+    {
+        glfwWindowHint(GLFW_REFRESH_RATE, mode->refreshRate);
+        window = glfwCreateWindow(mode->width, mode->height,
+                                  "Resize Stress", monitor, NULL);
+    }
+    else
+    {
+        glfwWindowHint(GLFW_REFRESH_RATE, 0);
+        window = glfwCreateWindow(WINDOWED_WIDTH, WINDOWED_HEIGHT,
+                                  "Resize Stress", NULL, NULL);
+    }
+
+    if (window)
+    {
+        glfwMakeContextCurrent(window);
+        glfwSwapInterval(0);
+    }
+
+    return window;
+#endif
+}
+
+static void report_transitions(void)
+{
+    int i;
+
+    for (i = 0;  i < TRANSITION_TYPE_COUNT;  i++)
+    {
+        int j, stalls = 0;
+        double* samples = transitions[i].samples;
+        const int count = transitions[i].count;
+
+        if (!count)
+        {
+            append("%s: no samples, %i timed out\r\n",
+                   transition_type_names[i],
+                   transitions[i].timeouts);
+            continue;
+        }
+
+        qsort(samples, count, sizeof(double), compare_doubles);
+
+        for (j = 0;  j < count;  j++)
+        {
+            if (samples[j] > STALL_THRESHOLD)
+                stalls++;
+        }
+
+        append("%s: %i samples, %0.1f min, %0.1f median, %0.1f p90, %0.1f max ms\r\n",
+               transition_type_names[i],
+               count,
+               samples[0] * 1000.0,
+               samples[count / 2] * 1000.0,
+               samples[count * 9 / 10] * 1000.0,
+               samples[count - 1] * 1000.0);
+
+        append("%s: %i over %i ms, %i timed out\r\n",
+               transition_type_names[i],
+               stalls,
+               (int) (STALL_THRESHOLD * 1000.0),
+               transitions[i].timeouts);
+    }
+}
+
+static unsigned int count_bits(unsigned int value)
+{
+    unsigned int count = 0;
+
+    for (;  value;  count++)
+        value &= value - 1;
+
+    return count;
+}
+
+// Returns the number of bytes that differ between the two RGBA buffers by
+// more than the tolerance of their channel
+//
+static size_t count_mismatches(const unsigned char* first,
+                               const unsigned char* second,
+                               size_t size)
+{
+    size_t i = 0, count = 0;
+    const unsigned char* tolerance = readback.tolerance;
+
+#if defined(HAVE_SSE2)
+    // Each 16 byte block starts on a pixel, so the channel pattern repeats
+    const __m128i limit = _mm_set1_epi32(tolerance[0] |
+                                         (tolerance[1] << 8) |
+                                         (tolerance[2] << 16) |
+                                         (tolerance[3] << 24));
+    const __m128i zero = _mm_setzero_si128();
+
+    for (;  i + 16 <= size;  i += 16)
+    {
+        const __m128i a = _mm_loadu_si128((const __m128i*) (first + i));
+        const __m128i b = _mm_loadu_si128((const __m128i*) (second + i));
+        const __m128i diff = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+        const __m128i excess = _mm_subs_epu8(diff, limit);
+        const unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(excess, zero));
+
+        if (mask != 0xffff)
+            count += 16 - count_bits(mask);
+    }
+#endif
+
+    for (;  i < size;  i++)
+    {
+        const int diff = first[i] > second[i] ? first[i] - second[i]
+                                              : second[i] - first[i];
+
+        if (diff > tolerance[i & 3])
+            count++;
+    }
+
+    return count;
+}
+
+// Fills the quadrants of the framebuffer with the colors of the pattern,
+// rotated by the frame index so that stale frames fail verification
+//
+static void draw_readback_pattern(int frame)
+{
+    int i;
+    const int width = readback.width / 2, height = readback.height / 2;
+
+    glEnable(GL_SCISSOR_TEST);
+
+    for (i = 0;  i < 4;  i++)
+    {
+        const unsigned char* color = readback_colors[(i + frame) % READBACK_PATTERNS];
+
+        glScissor((i & 1) * width, (i >> 1) * height, width, height);
+        glClearColor(color[0] / 255.f, color[1] / 255.f, color[2] / 255.f, 1.f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    glDisable(GL_SCISSOR_TEST);
+}
+
+static void generate_readback_pattern(unsigned char* pixels, int frame)
+{
+    int x, y;
+
+    for (y = 0;  y < readback.height;  y++)
+    {
+        for (x = 0;  x < readback.width;  x++)
+        {
+            const int quadrant = (x >= readback.width / 2) +
+                                 (y >= readback.height / 2) * 2;
+            const unsigned char* color =
+                readback_colors[(quadrant + frame) % READBACK_PATTERNS];
+
+            pixels[0] = color[0];
+            pixels[1] = color[1];
+            pixels[2] = color[2];
+            pixels[3] = 0xff;
+            pixels += 4;
+        }
+    }
+}
+
+static int load_readback_functions(GLFWwindow* window)
+{
+    const int major = glfwGetWindowAttrib(window, GLFW_CONTEXT_VERSION_MAJOR);
+    const int minor = glfwGetWindowAttrib(window, GLFW_CONTEXT_VERSION_MINOR);
+
+    if (major > 3 || (major == 3 && minor >= 2) ||
+        glfwExtensionSupported("GL_ARB_sync"))
+    {
+        readback.FenceSync = (PFNGLFENCESYNCPROC)
+            glfwGetProcAddress("glFenceSync");
+        readback.ClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)
+            glfwGetProcAddress("glClientWaitSync");
+        readback.DeleteSync = (PFNGLDELETESYNCPROC)
+            glfwGetProcAddress("glDeleteSync");
+    }
+
+    if (!readback.FenceSync || !readback.ClientWaitSync || !readback.DeleteSync)
+        readback.FenceSync = NULL;
+
+    if (major < 2 || (major == 2 && minor < 1))
+    {
+        if (!glfwExtensionSupported("GL_ARB_pixel_buffer_object"))
+            return 0;
+    }
+
+    readback.GenBuffers = (PFNGLGENBUFFERSPROC)
+        glfwGetProcAddress("glGenBuffers");
+    readback.DeleteBuffers = (PFNGLDELETEBUFFERSPROC)
+        glfwGetProcAddress("glDeleteBuffers");
+    readback.BindBuffer = (PFNGLBINDBUFFERPROC)
+        glfwGetProcAddress("glBindBuffer");
+    readback.BufferData = (PFNGLBUFFERDATAPROC)
+        glfwGetProcAddress("glBufferData");
+    readback.MapBuffer = (PFNGLMAPBUFFERPROC)
+        glfwGetProcAddress("glMapBuffer");
+    readback.UnmapBuffer = (PFNGLUNMAPBUFFERPROC)
+        glfwGetProcAddress("glUnmapBuffer");
+
+    return readback.GenBuffers && readback.DeleteBuffers &&
+           readback.BindBuffer && readback.BufferData &&
+           readback.MapBuffer && readback.UnmapBuffer;
+}
+
+// Allows each channel to be off by one step of its granted depth, as
+// drivers may round either way when quantizing the clear color
+//
+static void set_readback_tolerance(void)
+{
+    int i;
+    static const GLenum names[4] = { GL_RED_BITS, GL_GREEN_BITS, GL_BLUE_BITS, GL_ALPHA_BITS };
+
+    for (i = 0;  i < 4;  i++)
+    {
+        GLint bits = 0;
+        glGetIntegerv(names[i], &bits);
+        readback.bits[i] = bits;
+
+        if (bits >= 8)
+            readback.tolerance[i] = 0;
+        else if (bits > 0)
+            readback.tolerance[i] = (unsigned char) (256 >> bits);
+        else if (i == 3)
+        {
+            // Alpha is read back as one when there is no alpha channel
+            readback.tolerance[i] = 0;
+        }
+        else
+            readback.tolerance[i] = 255;
+    }
+}
+
+static void report_readback(const char* name, double elapsed, double waited, int failures)
+{
+    const double bytes = (double) readback.size * READBACK_FRAMES;
+
+    append("%s: %0.1f MB/s, %0.3f ms per frame, %0.3f ms waiting, %i of %i frames wrong\r\n",
+           name,
+           bytes / elapsed / (1024.0 * 1024.0),
+           elapsed * 1000.0 / READBACK_FRAMES,
+           waited * 1000.0 / READBACK_FRAMES,
+           failures,
+           READBACK_FRAMES);
+}
+
+static void run_sync_readback(GLFWwindow* window)
+{
+    int i, failures = 0;
+    double base, elapsed, waited = 0.0;
+
+    base = glfwGetTime();
+
+    for (i = 0;  i < READBACK_FRAMES;  i++)
+    {
+        double start;
+
+        draw_readback_pattern(i);
+
+        start = glfwGetTime();
+        glReadPixels(0, 0, readback.width, readback.height,
+                     GL_RGBA, GL_UNSIGNED_BYTE, readback.pixels);
+        waited += glfwGetTime() - start;
+
+        if (count_mismatches(readback.pixels,
+                             readback.expected[i % READBACK_PATTERNS],
+                             readback.size))
+        {
+            failures++;
+        }
+
+        glfwSwapBuffers(window);
+    }
+
+    elapsed = glfwGetTime() - base;
+
+    report_readback("Synchronous glReadPixels", elapsed, waited, failures);
+}
+
+static int verify_readback_buffer(GLuint buffer, GLsync* fence, int frame, double* waited)
+{
+    int result = 1;
+    const unsigned char* pixels;
+    const double start = glfwGetTime();
+
+    if (*fence)
+    {
+        const GLenum status = readback.ClientWaitSync(*fence,
+                                                      GL_SYNC_FLUSH_COMMANDS_BIT,
+                                                      READBACK_TIMEOUT);
+        readback.DeleteSync(*fence);
+        *fence = NULL;
+
+        if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+            result = 0;
+    }
+
+    readback.BindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+    pixels = readback.MapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    *waited += glfwGetTime() - start;
+
+    if (pixels)
+    {
+        if (count_mismatches(pixels,
+                             readback.expected[frame % READBACK_PATTERNS],
+                             readback.size))
+        {
+            result = 0;
+        }
+
+        readback.UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    else
+        result = 0;
+
+    readback.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return result;
+}
+
+static void run_pbo_readback(GLFWwindow* window, int bufferCount)
+{
+    int i, failures = 0;
+    char name[64];
+    double base, elapsed, waited = 0.0;
+    GLuint buffers[READBACK_MAX_BUFFERS];
+    GLsync fences[READBACK_MAX_BUFFERS];
+
+    memset(fences, 0, sizeof(fences));
+
+    readback.GenBuffers(bufferCount, buffers);
+    for (i = 0;  i < bufferCount;  i++)
+    {
+        readback.BindBuffer(GL_PIXEL_PACK_BUFFER, buffers[i]);
+        readback.BufferData(GL_PIXEL_PACK_BUFFER,
+                            readback.size, NULL, GL_STREAM_READ);
+    }
+
+    readback.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    base = glfwGetTime();
+
+    for (i = 0;  i < READBACK_FRAMES + bufferCount - 1;  i++)
+    {
+        if (i < READBACK_FRAMES)
+        {
+            const int index = i % bufferCount;
+
+            draw_readback_pattern(i);
+
+            readback.BindBuffer(GL_PIXEL_PACK_BUFFER, buffers[index]);
+            glReadPixels(0, 0, readback.width, readback.height,
+                         GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            readback.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            if (readback.FenceSync)
+                fences[index] = readback.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+            glfwSwapBuffers(window);
+        }
+
+        // Consume the oldest frame once the ring is full
+        if (i >= bufferCount - 1)
+        {
+            const int frame = i - (bufferCount - 1);
+            const int index = frame % bufferCount;
+
+            if (!verify_readback_buffer(buffers[index], fences + index, frame, &waited))
+                failures++;
+        }
+    }
+
+    elapsed = glfwGetTime() - base;
+
+    readback.DeleteBuffers(bufferCount, buffers);
+
+    sprintf(name, "Ring of %i pixel buffers%s",
+            bufferCount,
+            readback.FenceSync ? " with fences" : "");
+    report_readback(name, elapsed, waited, failures);
+}
+
+static const GLFWgammaramp* capture_gamma_ramp(const GLFWgammaramp* source,
+                                               GLFWgammaramp* target)
+{
+    if (source->size > ramps.capacity)
+    {
+        unsigned short* values =
+            realloc(ramps.values, sizeof(unsigned short) * 3 * source->size);
+        if (!values)
+            return NULL;
+
+        ramps.values = values;
+        ramps.capacity = source->size;
+    }
+
+    target->size = source->size;
+    target->red = ramps.values;
+    target->green = ramps.values + source->size;
+    target->blue = ramps.values + source->size * 2;
+
+    memcpy(target->red, source->red, sizeof(unsigned short) * source->size);
+    memcpy(target->green, source->green, sizeof(unsigned short) * source->size);
+    memcpy(target->blue, source->blue, sizeof(unsigned short) * source->size);
+
+    return target;
+}
+
+static double get_gamma_exponent(const unsigned short* values, unsigned int size)
+{
+    double x, y;
+
+    if (size < 3)
+        return 0.0;
+
+    x = (double) (size / 2) / (double) (size - 1);
+    y = (double) values[size / 2] / 65535.0;
+    if (y <= 0.0 || y >= 1.0)
+        return 0.0;
+
+    return log(y) / log(x);
+}
+
+static void append_monitor(int index,
+                           const char* name,
+                           int primary,
+                           const GLFWvidmode* mode,
+                           int xpos, int ypos,
+                           int widthMM, int heightMM,
+                           float xscale, float yscale,
+                           const GLFWvidmode* modes,
+                           int modeCount)
+{
+    int i, dpi;
+
+    append_separator();
+    append("Monitor %i (%s) %s\r\n",
+           index,
+           name ? name : "unknown",
+           primary ? "primary" : "secondary");
+
+    if (mode)
+    {
+        append("Current mode: %s\r\n", format_video_mode(mode));
+        dpi = get_dpi(mode->width, widthMM);
+    }
+    else
+    {
+        append("Current mode: unknown\r\n");
+        dpi = 0;
+    }
+
+    append("Virtual position: %i %i\r\n", xpos, ypos);
+
+    if (dpi)
+        append("Physical size: %i x %i mm (%i dpi)\r\n", widthMM, heightMM, dpi);
+    else
+        append("Physical size: %i x %i mm (unknown dpi)\r\n", widthMM, heightMM);
+
+    // Content scale is zero when GLFW is too old to report it
+    if (xscale > 0.f && yscale > 0.f)
+        append("Content scale: %0.2f x %0.2f\r\n", xscale, yscale);
+    else if (dpi)
+        append("Content scale: unknown (%0.2f estimated from dpi)\r\n", dpi / 96.0);
+    else
+        append("Content scale: unknown\r\n");
+
+    append("Modes:\r\n");
+    for (i = 0;  i < modeCount;  i++)
+        append("%4i: %s\r\n", i, format_video_mode(modes + i));
+}
+
+static void append_joystick(int index, const char* name, int axisCount, int buttonCount)
+{
+    if (name)
+    {
+        append("Joystick %i (%s): %i axes, %i buttons\r\n",
+               index, name, axisCount, buttonCount);
+    }
+    else
+        append("Joystick %i: not present\r\n", index);
+}
+
+static void append_extension_string(const char* extensions)
+{
+    if (!extensions)
+    {
+        append("Extension string is not available\r\n");
+        return;
+    }
+
+    while (*extensions != '\0')
+    {
+        const size_t length = strcspn(extensions, " ");
+
+        if (length)
+        {
+            append_text(extensions, length);
+            append_text("\r\n", 2);
+            extensions += length;
+        }
+        else
+            extensions++;
+    }
+}
+
+static const char* get_gl_string(GLenum name)
+{
+    const GLubyte* string = backend->getString(name);
+    if (!string)
+        return "unknown";
+
+    return (const char*) string;
+}
+
+static const char* get_client_api_name(int api)
+{
+    if (api == GLFW_OPENGL_API)
+        return "OpenGL";
+    else if (api == GLFW_OPENGL_ES_API)
+        return "OpenGL ES";
+
+    return "Unknown API";
+}
+
+static const char* get_profile_name_gl(GLint mask)
+{
+    if (mask & GL_CONTEXT_COMPATIBILITY_PROFILE_BIT)
+        return PROFILE_NAME_COMPAT;
+    if (mask & GL_CONTEXT_CORE_PROFILE_BIT)
+        return PROFILE_NAME_CORE;
+
+    return "unknown";
+}
+
+static const char* get_profile_name_glfw(int profile)
+{
+    if (profile == GLFW_OPENGL_COMPAT_PROFILE)
+        return PROFILE_NAME_COMPAT;
+    if (profile == GLFW_OPENGL_CORE_PROFILE)
+        return PROFILE_NAME_CORE;
+
+    return "unknown";
+}
+
+static const char* get_strategy_name_gl(GLint strategy)
+{
+    if (strategy == GL_LOSE_CONTEXT_ON_RESET_ARB)
+        return STRATEGY_NAME_LOSE;
+    if (strategy == GL_NO_RESET_NOTIFICATION_ARB)
+        return STRATEGY_NAME_NONE;
+
+    return "unknown";
+}
+
+static const char* get_strategy_name_glfw(int strategy)
+{
+    if (strategy == GLFW_LOSE_CONTEXT_ON_RESET)
+        return STRATEGY_NAME_LOSE;
+    if (strategy == GLFW_NO_RESET_NOTIFICATION)
+        return STRATEGY_NAME_NONE;
+
+    return "unknown";
+}
+
+static void append_header(void)
+{
+    const char* version = backend->getVersionString();
+
+    append("GLFWDIAG compiled on " __DATE__ "\r\n");
+    append("GLFW %s\r\n", version ? version : "unknown");
+}
+
+static void build_report(void)
+{
+    append_header();
+    report_monitors();
+    report_joysticks();
+
+    if (backend->getCurrentContext())
+    {
+        report_context();
+        report_extensions();
+    }
+}
+
+static unsigned int soak_random(void)
+{
+    // xorshift32, seeded so that every run generates the same sequence
+    soak.seed ^= soak.seed << 13;
+    soak.seed ^= soak.seed >> 17;
+    soak.seed ^= soak.seed << 5;
+    return soak.seed;
+}
+
+static int soak_range(int min, int max)
+{
+    return min + (int) (soak_random() % (unsigned int) (max - min + 1));
+}
+
+static int reserve_soak_extensions(size_t size)
+{
+    char* extensions;
+
+    if (size <= soak.capacity)
+        return 1;
+
+    extensions = realloc(soak.extensions, size);
+    if (!extensions)
+        return 0;
+
+    soak.extensions = extensions;
+    soak.capacity = size;
+    return 1;
+}
+
+static void generate_soak_name(char* name, size_t length)
+{
+    size_t i;
+
+    for (i = 0;  i < length;  i++)
+        name[i] = (char) soak_range('!', '~');
+
+    name[length] = '\0';
+}
+
+static const char* soak_key(const char* format, ...)
+{
+    va_list vl;
+    static char key[256];
+
+    va_start(vl, format);
+    vsnprintf(key, sizeof(key), format, vl);
+    va_end(vl);
+
+    key[sizeof(key) - 1] = '\0';
+    return key;
+}
+
+static const char* soak_int(int value)
+{
+    static char buffer[32];
+    sprintf(buffer, "%i", value);
+    return buffer;
+}
+
+static const char* soak_pair(int first, int second)
+{
+    static char buffer[32];
+    sprintf(buffer, "%i %i", first, second);
+    return buffer;
+}
+
+// Returns a random name, the shared name that is longer than any formatting
+// buffer, or NULL for a query that failed
+// Long names are only chosen when the caller passes a total to add them to,
+// meaning the name is certain to end up in the report
+//
+static const char* generate_soak_string(char* buffer, size_t size, size_t* expected)
+{
+    const int kind = soak_range(0, 1023);
+
+    if (kind == 0)
+        return NULL;
+
+    if (kind == 1 && expected && soak.hugeName)
+    {
+        *expected += SOAK_HUGE_NAME_SIZE;
+        soak.hugeLines++;
+        return soak.hugeName;
+    }
+
+    generate_soak_name(buffer, soak_range(0, size - 1));
+    return buffer;
+}
+
+// Sets the key to a random string, or leaves it missing
+//
+static void set_soak_string(const char* key, size_t* expected)
+{
+    char buffer[256];
+
+    if (soak_range(0, 15))
+        set_capture_value(key, generate_soak_string(buffer, sizeof(buffer), expected));
+}
+
+// Generates a mode list in capture format, sometimes malformed
+//
+static const char* generate_soak_modes(char* buffer, int count)
+{
+    int i;
+    size_t length;
+
+    switch (soak_range(0, 63))
+    {
+        case 0:
+            return "-1";
+        case 1:
+            return "99999999 1 2 3";
+        case 2:
+            return "2 640 480";
+    }
+
+    length = sprintf(buffer, "%i", count);
+
+    for (i = 0;  i < count;  i++)
+    {
+        length += sprintf(buffer + length, " %i %i %i %i %i %i",
+                          soak_range(-65535, 65535),
+                          soak_range(-65535, 65535),
+                          soak_range(-16, 16),
+                          soak_range(-16, 16),
+                          soak_range(-16, 16),
+                          soak_range(-1000, 1000));
+    }
+
+    return buffer;
+}
+
+// Generates an extension string with a random pathology, or NULL
+//
+static const char* generate_soak_extensions(size_t* expected)
+{
+    size_t i, length = 0;
+    const int kind = soak_range(0, 1023);
+
+    if (kind == 0)
+        return NULL;
+
+    if (kind == 1 && soak.hugeName)
+    {
+        *expected += SOAK_HUGE_NAME_SIZE;
+        soak.hugeLines++;
+        return soak.hugeName;
+    }
+
+    if (!reserve_soak_extensions(SOAK_MAX_EXTENSIONS * 68 + 1))
+        return NULL;
+
+    if (kind < 64)
+    {
+        // Empty or whitespace only
+        length = soak_range(0, 64);
+        memset(soak.extensions, ' ', length);
+    }
+    else
+    {
+        const int count = soak_range(0, SOAK_MAX_EXTENSIONS);
+
+        for (i = 0;  i < (size_t) count;  i++)
+        {
+            const size_t spaces = soak_range(0, 3);
+            const size_t nameLength = soak_range(1, 64);
+
+            memset(soak.extensions + length, ' ', spaces);
+            length += spaces;
+
+            generate_soak_name(soak.extensions + length, nameLength);
+            length += nameLength;
+        }
+    }
+
+    soak.extensions[length] = '\0';
+    return soak.extensions;
+}
+
+static void generate_soak_monitors(char* modes, size_t* expected)
+{
+    int i, monitorCount = soak_range(0, SOAK_MAX_MONITORS);
+
+    if (soak_range(0, 31))
+        set_capture_value(CAPTURE_MONITORS, soak_int(monitorCount));
+    else
+    {
+        set_capture_value(CAPTURE_MONITORS, soak_range(0, 1) ? "many" : "-3");
+        monitorCount = 0;
+    }
+
+    set_capture_value(CAPTURE_PRIMARY, soak_int(soak_range(-1, monitorCount)));
+
+    for (i = 0;  i < monitorCount;  i++)
+    {
+        set_soak_string(soak_key(CAPTURE_MONITOR_NAME, i), expected);
+
+        set_capture_value(soak_key(CAPTURE_MONITOR_POS, i),
+                          soak_range(0, 31) ? soak_pair(soak_range(-65535, 65535),
+                                                        soak_range(-65535, 65535))
+                                            : "1");
+        set_capture_value(soak_key(CAPTURE_MONITOR_SIZE, i),
+                          soak_pair(soak_range(0, 3) ? soak_range(0, 1000) : 0,
+                                    soak_range(0, 3) ? soak_range(0, 1000) : 0));
+        set_capture_value(soak_key(CAPTURE_MONITOR_SCALE, i),
+                          soak_pair(soak_range(0, 3), soak_range(0, 3)));
+
+        if (soak_range(0, 15))
+        {
+            set_capture_value(soak_key(CAPTURE_MONITOR_MODE, i),
+                              generate_soak_modes(modes, 1));
+        }
+
+        set_capture_value(soak_key(CAPTURE_MONITOR_MODES, i),
+                          generate_soak_modes(modes, soak_range(0, SOAK_MAX_MODES)));
+    }
+}
+
+static void generate_soak_joysticks(size_t* expected)
+{
+    int i;
+
+    for (i = GLFW_JOYSTICK_1;  i < GLFW_JOYSTICK_LAST;  i++)
+    {
+        const int present = (soak_range(0, 3) == 0);
+
+        set_capture_value(soak_key(CAPTURE_JOYSTICK_PRESENT, i), soak_int(present));
+        if (!present)
+            continue;
+
+        set_soak_string(soak_key(CAPTURE_JOYSTICK_NAME, i), expected);
+        set_capture_value(soak_key(CAPTURE_JOYSTICK_AXES, i),
+                          soak_range(0, 31) ? soak_int(soak_range(0, 64)) : "99999999");
+        set_capture_value(soak_key(CAPTURE_JOYSTICK_BUTTONS, i),
+                          soak_range(0, 31) ? soak_int(soak_range(0, 256)) : "-1");
+    }
+}
+
+static void generate_soak_context(size_t* expected)
+{
+    int i, count;
+    static const int apis[] = { GLFW_OPENGL_API, GLFW_OPENGL_API, GLFW_OPENGL_ES_API, 0 };
+    static const int robustness[] = { GLFW_NO_ROBUSTNESS, GLFW_NO_RESET_NOTIFICATION, GLFW_LOSE_CONTEXT_ON_RESET };
+    static const int profiles[] = { 0, GLFW_OPENGL_CORE_PROFILE, GLFW_OPENGL_COMPAT_PROFILE };
+    static const int strategies[] = { 0, GL_NO_RESET_NOTIFICATION_ARB, GL_LOSE_CONTEXT_ON_RESET_ARB };
+    const int major = soak_range(1, 4);
+
+    if (soak_range(0, 15) == 0)
+    {
+        set_capture_value(CAPTURE_CONTEXT, "0");
+        return;
+    }
+
+    set_capture_value(CAPTURE_CONTEXT, "1");
+
+    set_capture_value(soak_key(CAPTURE_ATTRIB, GLFW_CLIENT_API),
+                      soak_int(apis[soak_range(0, 3)]));
+    set_capture_value(soak_key(CAPTURE_ATTRIB, GLFW_CONTEXT_VERSION_MAJOR),
+                      soak_int(major));
+    set_capture_value(soak_key(CAPTURE_ATTRIB, GLFW_CONTEXT_VERSION_MINOR),
+                      soak_int(soak_range(0, 6)));
+    set_capture_value(soak_key(CAPTURE_ATTRIB, GLFW_CONTEXT_REVISION),
+                      soak_int(soak_range(0, 9)));
+    set_capture_value(soak_key(CAPTURE_ATTRIB, GLFW_OPENGL_FORWARD_COMPAT),
+                      soak_int(soak_range(0, 1)));
+    set_capture_value(soak_key(CAPTURE_ATTRIB, GLFW_OPENGL_DEBUG_CONTEXT),
+                      soak_int(soak_range(0, 1)));
+    set_capture_value(soak_key(CAPTURE_ATTRIB, GLFW_CONTEXT_ROBUSTNESS),
+                      soak_int(robustness[soak_range(0, 2)]));
+    set_capture_value(soak_key(CAPTURE_ATTRIB, GLFW_OPENGL_PROFILE),
+                      soak_int(profiles[soak_range(0, 2)]));
+
+    set_soak_string(soak_key(CAPTURE_STRING, GL_VERSION), NULL);
+    set_soak_string(soak_key(CAPTURE_STRING, GL_RENDERER), expected);
+    set_soak_string(soak_key(CAPTURE_STRING, GL_VENDOR), NULL);
+    set_soak_string(soak_key(CAPTURE_STRING, GL_SHADING_LANGUAGE_VERSION), NULL);
+
+    set_capture_value(soak_key(CAPTURE_INTEGER, GL_CONTEXT_FLAGS),
+                      soak_int(soak_range(0, 15)));
+    set_capture_value(soak_key(CAPTURE_INTEGER, GL_CONTEXT_PROFILE_MASK),
+                      soak_int(soak_range(0, 3)));
+    set_capture_value(soak_key(CAPTURE_INTEGER, GL_RESET_NOTIFICATION_STRATEGY_ARB),
+                      soak_int(strategies[soak_range(0, 2)]));
+    set_capture_value(soak_key(CAPTURE_EXTENSION, "GL_ARB_robustness"),
+                      soak_int(soak_range(0, 1)));
+
+    if (major > 2)
+    {
+        char buffer[256];
+
+        // Sometimes glGetStringi is missing from a 3.x context
+        if (soak_range(0, 15) == 0)
+        {
+            set_capture_value(CAPTURE_STRINGI_LOADED, "0");
+            return;
+        }
+
+        set_capture_value(CAPTURE_STRINGI_LOADED, "1");
+
+        count = soak_range(-1, SOAK_MAX_EXTENSIONS);
 
-    return "unknown";
+        // Sometimes the count is far larger than the capture could hold
+        if (soak_range(0, 255) == 0)
+        {
+            set_capture_value(soak_key(CAPTURE_INTEGER, GL_NUM_EXTENSIONS),
+                              soak_range(0, 1) ? "2147483647" : "20000000");
+        }
+        else
+        {
+            set_capture_value(soak_key(CAPTURE_INTEGER, GL_NUM_EXTENSIONS),
+                              soak_int(count));
+        }
+
+        for (i = 0;  i < count;  i++)
+        {
+            set_capture_value(soak_key(CAPTURE_STRINGI, GL_EXTENSIONS, i),
+                              generate_soak_string(buffer, 65, expected));
+        }
+    }
+    else
+    {
+        set_capture_value(soak_key(CAPTURE_STRING, GL_EXTENSIONS),
+                          generate_soak_extensions(expected));
+    }
 }
 
-static const char* get_profile_name_glfw(int profile)
+// Builds a random capture and generates the full report from it through
+// the replay backend
+//
+static void run_soak_iteration(void)
 {
-    if (profile == GLFW_OPENGL_COMPAT_PROFILE)
-        return PROFILE_NAME_COMPAT;
-    if (profile == GLFW_OPENGL_CORE_PROFILE)
-        return PROFILE_NAME_CORE;
+    size_t expected = 0;
+    char modes[SOAK_MAX_MODES * 72 + 16];
 
-    return "unknown";
-}
+    clear_capture();
 
-static const char* get_strategy_name_gl(GLint strategy)
-{
-    if (strategy == GL_LOSE_CONTEXT_ON_RESET_ARB)
-        return STRATEGY_NAME_LOSE;
-    if (strategy == GL_NO_RESET_NOTIFICATION_ARB)
-        return STRATEGY_NAME_NONE;
+    if (soak_range(0, 15))
+    {
+        char buffer[64];
+        generate_soak_name(buffer, soak_range(0, sizeof(buffer) - 1));
+        set_capture_value(CAPTURE_VERSION, buffer);
+    }
 
-    return "unknown";
-}
+    generate_soak_monitors(modes, &expected);
+    generate_soak_joysticks(&expected);
+    generate_soak_context(&expected);
 
-static const char* get_strategy_name_glfw(int strategy)
-{
-    if (strategy == GLFW_LOSE_CONTEXT_ON_RESET)
-        return STRATEGY_NAME_LOSE;
-    if (strategy == GLFW_NO_RESET_NOTIFICATION)
-        return STRATEGY_NAME_NONE;
+    report.length = 0;
 
-    return "unknown";
+    backend = &replay_backend;
+    build_report();
+    backend = &live_backend;
+
+    // Every long name adds more than the whole report would otherwise hold
+    if (report.length < expected)
+        soak.truncations++;
 }
 
 int report_init(void)
@@ -149,14 +1563,16 @@ int report_init(void)
     if (!glfwInit())
         return 0;
 
-    append("GLFWDIAG compiled on " __DATE__ "\r\n");
-    append("GLFW %s\r\n", glfwGetVersionString());
-
+    append_header();
     return 1;
 }
 
 void report_terminate(void)
 {
+    free(ramps.values);
+    memset(&ramps, 0, sizeof(ramps));
+
+    clear_capture();
     glfwTerminate();
 }
 
@@ -165,33 +1581,89 @@ void report_monitors(void)
     int i, monitorCount;
     GLFWmonitor** monitors;
 
-    monitors = glfwGetMonitors(&monitorCount);
+    monitors = backend->getMonitors(&monitorCount);
     for (i = 0;  i < monitorCount;  i++)
     {
-        int j, xpos, ypos, widthMM, heightMM, dpi, modeCount;
+        int xpos, ypos, widthMM, heightMM, modeCount;
+        float xscale, yscale;
         const GLFWvidmode* modes;
-        const int primary = (glfwGetPrimaryMonitor() == monitors[i]);
-        const GLFWvidmode* mode = glfwGetVideoMode(monitors[i]);
 
-        glfwGetMonitorPos(monitors[i], &xpos, &ypos);
-        glfwGetMonitorPhysicalSize(monitors[i], &widthMM, &heightMM);
+        backend->getMonitorPos(monitors[i], &xpos, &ypos);
+        backend->getMonitorPhysicalSize(monitors[i], &widthMM, &heightMM);
+        backend->getMonitorContentScale(monitors[i], &xscale, &yscale);
+        modes = backend->getVideoModes(monitors[i], &modeCount);
+
+        append_monitor(i,
+                       backend->getMonitorName(monitors[i]),
+                       backend->getPrimaryMonitor() == monitors[i],
+                       backend->getVideoMode(monitors[i]),
+                       xpos, ypos,
+                       widthMM, heightMM,
+                       xscale, yscale,
+                       modes, modeCount);
+    }
+}
+
+void report_gamma_ramps(void)
+{
+    int i, monitorCount;
+    GLFWmonitor** monitors;
+
+    monitors = glfwGetMonitors(&monitorCount);
+    for (i = 0;  i < monitorCount;  i++)
+    {
+        int j;
+        double base, getTimes[GAMMA_SAMPLES], setTimes[GAMMA_SAMPLES];
+        GLFWgammaramp ramp;
+        const GLFWgammaramp* current;
 
         append_separator();
-        append("Monitor %i (%s) %s\r\n",
+        append("Monitor %i (%s) gamma ramp\r\n",
                i,
-               glfwGetMonitorName(monitors[i]),
-               primary ? "primary" : "secondary");
+               glfwGetMonitorName(monitors[i]));
 
-        append("Current mode: %s\r\n", format_video_mode(mode));
-        append("Virtual position: %i %i\r\n", xpos, ypos);
+        current = glfwGetGammaRamp(monitors[i]);
+        if (!current || !current->size)
+        {
+            append("Gamma ramp not available\r\n");
+            continue;
+        }
 
-        dpi = (int) ((float) mode->width * 25.4f / (float) widthMM);
-        append("Physical size: %i x %i mm (%i dpi)\r\n", widthMM, heightMM, dpi);
+        if (!capture_gamma_ramp(current, &ramp))
+        {
+            append("Failed to allocate gamma ramp of size %u\r\n", current->size);
+            continue;
+        }
 
-        append("Modes:\r\n");
-        modes = glfwGetVideoModes(monitors[i], &modeCount);
-        for (j = 0;  j < modeCount;  j++)
-            append("%4i: %s\r\n", j, format_video_mode(modes + j));
+        // Setting the ramp we just read is visually a no-op but still costs
+        // the full round trip to the display server or driver
+        // The first set also makes GLFW read and save the original ramp, so
+        // it is done once untimed before sampling
+        glfwSetGammaRamp(monitors[i], &ramp);
+
+        for (j = 0;  j < GAMMA_SAMPLES;  j++)
+        {
+            base = glfwGetTime();
+            glfwGetGammaRamp(monitors[i]);
+            getTimes[j] = (glfwGetTime() - base) * 1000.0;
+
+            base = glfwGetTime();
+            glfwSetGammaRamp(monitors[i], &ramp);
+            setTimes[j] = (glfwGetTime() - base) * 1000.0;
+        }
+
+        qsort(getTimes, GAMMA_SAMPLES, sizeof(double), compare_doubles);
+        qsort(setTimes, GAMMA_SAMPLES, sizeof(double), compare_doubles);
+
+        append("Ramp size: %u entries\r\n", ramp.size);
+        append("Getting the ramp took %0.3f ms min, %0.3f ms median over %i calls\r\n",
+               getTimes[0], getTimes[GAMMA_SAMPLES / 2], GAMMA_SAMPLES);
+        append("Setting the ramp took %0.3f ms min, %0.3f ms median over %i calls\r\n",
+               setTimes[0], setTimes[GAMMA_SAMPLES / 2], GAMMA_SAMPLES);
+        append("Estimated gamma: R %0.2f G %0.2f B %0.2f\r\n",
+               get_gamma_exponent(ramp.red, ramp.size),
+               get_gamma_exponent(ramp.green, ramp.size),
+               get_gamma_exponent(ramp.blue, ramp.size));
     }
 }
 
@@ -203,35 +1675,34 @@ void report_joysticks(void)
 
     for (i = GLFW_JOYSTICK_1;  i < GLFW_JOYSTICK_LAST;  i++)
     {
-        if (glfwJoystickPresent(i))
+        if (backend->joystickPresent(i))
         {
             int axisCount, buttonCount;
+            const char* name;
 
-            glfwGetJoystickAxes(i, &axisCount);
-            glfwGetJoystickButtons(i, &buttonCount);
+            backend->getJoystickAxes(i, &axisCount);
+            backend->getJoystickButtons(i, &buttonCount);
+            name = backend->getJoystickName(i);
 
-            append("Joystick %i (%s): %i axes, %i buttons\r\n",
-                   i,
-                   glfwGetJoystickName(i),
-                   axisCount, buttonCount);
+            append_joystick(i, name ? name : "unknown", axisCount, buttonCount);
         }
         else
-            append("Joystick %i: not present\r\n", i);
+            append_joystick(i, NULL, 0, 0);
     }
 }
 
 void report_context(void)
 {
-    GLFWwindow* window = glfwGetCurrentContext();
-    const int api = glfwGetWindowAttrib(window, GLFW_CLIENT_API);
-    const int major = glfwGetWindowAttrib(window, GLFW_CONTEXT_VERSION_MAJOR);
-    const int minor = glfwGetWindowAttrib(window, GLFW_CONTEXT_VERSION_MINOR);
-    const int rev = glfwGetWindowAttrib(window, GLFW_CONTEXT_REVISION);
+    GLFWwindow* window = backend->getCurrentContext();
+    const int api = backend->getWindowAttrib(window, GLFW_CLIENT_API);
+    const int major = backend->getWindowAttrib(window, GLFW_CONTEXT_VERSION_MAJOR);
+    const int minor = backend->getWindowAttrib(window, GLFW_CONTEXT_VERSION_MINOR);
+    const int rev = backend->getWindowAttrib(window, GLFW_CONTEXT_REVISION);
 
     append_separator();
     append("%s context version string: \"%s\"\r\n",
            get_client_api_name(api),
-           glGetString(GL_VERSION));
+           get_gl_string(GL_VERSION));
     append("%s context version parsed by GLFW: %u.%u.%u\r\n",
            get_client_api_name(api),
            major, minor, rev);
@@ -240,8 +1711,7 @@ void report_context(void)
     {
         if (major >= 3)
         {
-            GLint flags;
-            glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+            const GLint flags = backend->getInteger(GL_CONTEXT_FLAGS);
             append("%s context flags (0x%08x):", get_client_api_name(api), flags);
 
             if (flags & GL_CONTEXT_FLAG_FORWARD_COMPATIBLE_BIT)
@@ -254,21 +1724,20 @@ void report_context(void)
 
             append("%s context flags parsed by GLFW:", get_client_api_name(api));
 
-            if (glfwGetWindowAttrib(window, GLFW_OPENGL_FORWARD_COMPAT))
-                printf(" forward-compatible");
-            if (glfwGetWindowAttrib(window, GLFW_OPENGL_DEBUG_CONTEXT))
-                printf(" debug");
-            if (glfwGetWindowAttrib(window, GLFW_CONTEXT_ROBUSTNESS) != GLFW_NO_ROBUSTNESS)
-                printf(" robustness");
+            if (backend->getWindowAttrib(window, GLFW_OPENGL_FORWARD_COMPAT))
+                append(" forward-compatible");
+            if (backend->getWindowAttrib(window, GLFW_OPENGL_DEBUG_CONTEXT))
+                append(" debug");
+            if (backend->getWindowAttrib(window, GLFW_CONTEXT_ROBUSTNESS) != GLFW_NO_ROBUSTNESS)
+                append(" robustness");
             append("\r\n");
         }
 
         if (major > 3 || (major == 3 && minor >= 2))
         {
-            GLint mask;
-            int profile = glfwGetWindowAttrib(window, GLFW_OPENGL_PROFILE);
+            const GLint mask = backend->getInteger(GL_CONTEXT_PROFILE_MASK);
+            const int profile = backend->getWindowAttrib(window, GLFW_OPENGL_PROFILE);
 
-            glGetIntegerv(GL_CONTEXT_PROFILE_MASK, &mask);
             append("%s profile mask (0x%08x): %s\r\n",
                    get_client_api_name(api),
                    mask,
@@ -279,18 +1748,18 @@ void report_context(void)
                    get_profile_name_glfw(profile));
         }
 
-        if (glfwExtensionSupported("GL_ARB_robustness"))
+        if (backend->extensionSupported("GL_ARB_robustness"))
         {
             int robustness;
-            GLint strategy;
-            glGetIntegerv(GL_RESET_NOTIFICATION_STRATEGY_ARB, &strategy);
+            const GLint strategy =
+                backend->getInteger(GL_RESET_NOTIFICATION_STRATEGY_ARB);
 
             append("%s robustness strategy (0x%08x): %s\r\n",
                    get_client_api_name(api),
                    strategy,
                    get_strategy_name_gl(strategy));
 
-            robustness = glfwGetWindowAttrib(window, GLFW_CONTEXT_ROBUSTNESS);
+            robustness = backend->getWindowAttrib(window, GLFW_CONTEXT_ROBUSTNESS);
 
             append("%s robustness strategy parsed by GLFW: %s\r\n",
                    get_client_api_name(api),
@@ -300,16 +1769,16 @@ void report_context(void)
 
     append("%s context renderer string: \"%s\"\r\n",
            get_client_api_name(api),
-           glGetString(GL_RENDERER));
+           get_gl_string(GL_RENDERER));
     append("%s context vendor string: \"%s\"\r\n",
            get_client_api_name(api),
-           glGetString(GL_VENDOR));
+           get_gl_string(GL_VENDOR));
 
     if (major > 1)
     {
         append("%s context shading language version: \"%s\"\r\n",
                get_client_api_name(api),
-               glGetString(GL_SHADING_LANGUAGE_VERSION));
+               get_gl_string(GL_SHADING_LANGUAGE_VERSION));
     }
 }
 
@@ -317,46 +1786,36 @@ void report_extensions(void)
 {
     int i;
     GLint count;
-    const GLubyte* extensions;
-    GLFWwindow* window = glfwGetCurrentContext();
+    GLFWwindow* window = backend->getCurrentContext();
 
     append_separator();
     append("%s context supported extensions:\r\n",
-           get_client_api_name(glfwGetWindowAttrib(window, GLFW_CLIENT_API)));
+           get_client_api_name(backend->getWindowAttrib(window, GLFW_CLIENT_API)));
 
-    if (glfwGetWindowAttrib(window, GLFW_CONTEXT_VERSION_MAJOR) > 2)
+    if (backend->getWindowAttrib(window, GLFW_CONTEXT_VERSION_MAJOR) > 2)
     {
-        PFNGLGETSTRINGIPROC glGetStringi =
-            (PFNGLGETSTRINGIPROC) glfwGetProcAddress("glGetStringi");
-        if (!glGetStringi)
+        if (!backend->loadStringi())
         {
-            glfwTerminate();
-            exit(EXIT_FAILURE);
+            append("glGetStringi is not available\r\n");
+            return;
         }
 
-        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        count = backend->getInteger(GL_NUM_EXTENSIONS);
 
         for (i = 0;  i < count;  i++)
-            append("%s\r\n", glGetStringi(GL_EXTENSIONS, i));
-    }
-    else
-    {
-        extensions = glGetString(GL_EXTENSIONS);
-        while (*extensions != '\0')
         {
-            if (*extensions == ' ')
-                append("\r\n");
-            else
-                append("%c", *extensions);
-
-            extensions++;
+            const GLubyte* name = backend->getStringi(GL_EXTENSIONS, i);
+            if (name)
+                append("%s\r\n", name);
         }
     }
+    else
+        append_extension_string((const char*) backend->getString(GL_EXTENSIONS));
 }
 
 char* get_report(void)
 {
-    return report;
+    return report.text;
 }
 
 int test_default_window(void)
@@ -394,3 +1853,500 @@ int test_default_window(void)
     return 1;
 }
 
+int test_event_loop(void)
+{
+    int i;
+    GLFWwindow* window;
+    double idleTime = 0.0;
+
+    append_separator();
+    append("Benchmarking the event loop\r\n");
+
+    glfwDefaultWindowHints();
+
+    window = glfwCreateWindow(640, 480, "Event Loop", NULL, NULL);
+    if (!window)
+        return 0;
+
+    glfwSetWindowPosCallback(window, window_pos_callback);
+    glfwSetWindowSizeCallback(window, window_size_callback);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
+    glfwSetWindowFocusCallback(window, window_focus_callback);
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetCharCallback(window, char_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetCursorPosCallback(window, cursor_pos_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+
+    // Flush the events generated by window creation
+    glfwPollEvents();
+
+    for (i = 0;  i < EVENT_PHASE_COUNT;  i++)
+    {
+        unsigned int dispatched;
+        double total;
+
+        memset(&events, 0, sizeof(events));
+        total = run_event_phase(window, i, &dispatched);
+
+        if (i == EVENT_PHASE_IDLE)
+            idleTime = total;
+
+        append("Requesting and polling during %s phase: %0.3f us per iteration, %u events dispatched\r\n",
+               event_phase_names[i],
+               total * 1000000.0 / EVENT_ITERATIONS,
+               dispatched);
+
+        if (i != EVENT_PHASE_IDLE && dispatched)
+        {
+            int j;
+
+            append("Request and dispatch cost above idle: %0.3f us per event\r\n",
+                   (total - idleTime) * 1000000.0 / dispatched);
+
+            for (j = 0;  j < EVENT_TYPE_COUNT;  j++)
+            {
+                if (events.counts[j])
+                {
+                    append("%8u %s, %0.3f us until callback\r\n",
+                           events.counts[j],
+                           event_type_names[j],
+                           events.times[j] * 1000000.0 / events.counts[j]);
+                }
+            }
+        }
+    }
+
+#if defined(HAVE_EMPTY_EVENT)
+    test_empty_event_latency();
+#else
+    append("Empty event wakeup latency requires GLFW 3.1 or later\r\n");
+#endif
+
+    glfwDestroyWindow(window);
+    return 1;
+}
+
+int test_window_resize(void)
+{
+    int i, monitorCount;
+    int windowWidth, windowHeight, framebufferWidth, framebufferHeight;
+    GLFWmonitor** monitors;
+    GLFWwindow* window;
+    double base;
+
+    append_separator();
+    append("Stress testing window reconfiguration\r\n");
+
+    memset(transitions, 0, sizeof(transitions));
+
+    glfwDefaultWindowHints();
+
+    window = glfwCreateWindow(WINDOWED_WIDTH, WINDOWED_HEIGHT,
+                              "Resize Stress", NULL, NULL);
+    if (!window)
+        return 0;
+
+    glfwMakeContextCurrent(window);
+
+    // Measure the driver rather than the display refresh rate
+    glfwSwapInterval(0);
+
+    glfwGetWindowSize(window, &windowWidth, &windowHeight);
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+
+    framebuffer_scale = 1.0;
+    if (windowWidth > 0)
+        framebuffer_scale = (double) framebufferWidth / windowWidth;
+
+    wait_for_stable_frame(window, WINDOWED_WIDTH, WINDOWED_HEIGHT, glfwGetTime());
+
+    for (i = 0;  i < RESIZE_CYCLES;  i++)
+    {
+        const int* size = resize_sizes[i % (sizeof(resize_sizes) / sizeof(resize_sizes[0]))];
+
+        base = glfwGetTime();
+        glfwSetWindowSize(window, size[0], size[1]);
+        add_transition_sample(TRANSITION_RESIZE,
+                              wait_for_stable_frame(window, size[0], size[1], base));
+    }
+
+    monitors = glfwGetMonitors(&monitorCount);
+    for (i = 0;  i < monitorCount;  i++)
+    {
+        int j, modeCount;
+        const GLFWvidmode* modes = glfwGetVideoModes(monitors[i], &modeCount);
+
+        for (j = 0;  j < modeCount;  j++)
+        {
+            // The mode array may not survive the mode switches below
+            const GLFWvidmode mode = modes[j];
+
+            if (transitions[TRANSITION_FULLSCREEN].count +
+                transitions[TRANSITION_FULLSCREEN].timeouts >= TRANSITION_SAMPLES)
+            {
+                break;
+            }
+
+            base = glfwGetTime();
+            window = set_window_monitor(window, monitors[i], &mode);
+            if (!window)
+            {
+                append("Failed to enter full screen mode %s\r\n",
+                       format_video_mode(&mode));
+                report_transitions();
+                return 0;
+            }
+
+            add_transition_sample(TRANSITION_FULLSCREEN,
+                                  wait_for_stable_frame(window, mode.width, mode.height, base));
+
+            base = glfwGetTime();
+            window = set_window_monitor(window, NULL, NULL);
+            if (!window)
+            {
+                append("Failed to return to windowed mode\r\n");
+                report_transitions();
+                return 0;
+            }
+
+            add_transition_sample(TRANSITION_WINDOWED,
+                                  wait_for_stable_frame(window,
+                                                        WINDOWED_WIDTH,
+                                                        WINDOWED_HEIGHT,
+                                                        base));
+
+            modes = glfwGetVideoModes(monitors[i], &modeCount);
+        }
+    }
+
+    report_transitions();
+
+    glfwDestroyWindow(window);
+    return 1;
+}
+
+int test_report_soak(void)
+{
+    int i, result = 1;
+    double base = 0.0, blockTimes[SOAK_BLOCK_COUNT];
+    unsigned int warmAllocations = 0, maxAllocations = 0;
+    unsigned int captureAllocations, maxCaptureAllocations = 0;
+    size_t warmMemory, finalMemory, peakMemory, peakLength = 0, capacity;
+    const int blockSize = SOAK_ITERATIONS / SOAK_BLOCK_COUNT;
+    const char* failure = NULL;
+
+    // Run against a scratch report so the real one is left untouched
+    const report_buffer saved = report;
+
+    memset(&report, 0, sizeof(report));
+    memset(&soak, 0, sizeof(soak));
+    soak.seed = 0x9e3779b9;
+
+    // Lines built from this name overflow every fixed formatting buffer
+    soak.hugeName = malloc(SOAK_HUGE_NAME_SIZE + 1);
+    if (soak.hugeName)
+        generate_soak_name(soak.hugeName, SOAK_HUGE_NAME_SIZE);
+
+    get_memory_usage(&warmMemory, &peakMemory);
+    captureAllocations = get_capture_allocations();
+
+    for (i = 0;  i < SOAK_ITERATIONS;  i++)
+    {
+        const unsigned int before = report.allocations + report.formatAllocations;
+        const unsigned int captureBefore = get_capture_allocations();
+
+        if (i % blockSize == 0)
+        {
+            if (i / blockSize == 1)
+            {
+                warmAllocations = report.allocations;
+                get_memory_usage(&warmMemory, &peakMemory);
+            }
+
+            base = glfwGetTime();
+        }
+
+        run_soak_iteration();
+
+        if (report.allocations + report.formatAllocations - before > maxAllocations)
+            maxAllocations = report.allocations + report.formatAllocations - before;
+        if (get_capture_allocations() - captureBefore > maxCaptureAllocations)
+            maxCaptureAllocations = get_capture_allocations() - captureBefore;
+        if (report.length > peakLength)
+            peakLength = report.length;
+
+        if ((i + 1) % blockSize == 0)
+            blockTimes[i / blockSize] = glfwGetTime() - base;
+        else if ((i + 1) % SOAK_PROGRESS_INTERVAL == 0)
+        {
+            // Keep the frontend responsive without counting it as soak time
+            const double pause = glfwGetTime();
+            show_progress("Report soak", (int) ((i + 1) * 100.0 / SOAK_ITERATIONS));
+            base += glfwGetTime() - pause;
+        }
+    }
+
+    show_progress(NULL, 0);
+    get_memory_usage(&finalMemory, &peakMemory);
+
+    // The last random capture must not be mistaken for a loaded one
+    clear_capture();
+
+    capacity = report.capacity;
+    warmAllocations = report.allocations - warmAllocations;
+    captureAllocations = get_capture_allocations() - captureAllocations;
+
+    if (soak.truncations)
+        failure = "long lines were truncated";
+    else if (!soak.hugeLines)
+        failure = "no lines longer than the formatting buffer were generated";
+    else if (capacity > SOAK_MEMORY_LIMIT)
+        failure = "report buffer exceeded its memory limit";
+    else if (warmAllocations > SOAK_ALLOCATION_LIMIT)
+        failure = "report buffer allocations kept growing after warm-up";
+    else if (finalMemory > warmMemory + SOAK_GROWTH_LIMIT)
+        failure = "private memory kept growing after warm-up";
+    else if (blockTimes[SOAK_BLOCK_COUNT - 1] > blockTimes[1] * SOAK_SLOWDOWN_LIMIT)
+        failure = "throughput regressed during the run";
+
+    free(report.text);
+    free(soak.extensions);
+    free(soak.hugeName);
+
+    report = saved;
+
+    append_separator();
+    append("Soak testing the report pipeline with %i iterations\r\n",
+           SOAK_ITERATIONS);
+
+    for (i = 0;  i < SOAK_BLOCK_COUNT;  i++)
+    {
+        append("Block %i: %0.3f us per iteration\r\n",
+               i, blockTimes[i] * 1000000.0 / blockSize);
+    }
+
+    append("Report buffer: %lu bytes peak length, %lu bytes capacity\r\n",
+           (unsigned long) peakLength, (unsigned long) capacity);
+    append("Report buffer allocations: %u after warm-up, at most %u in one iteration\r\n",
+           warmAllocations, maxAllocations);
+    append("Capture and replay allocations: %0.1f per iteration, at most %u in one iteration\r\n",
+           (double) captureAllocations / SOAK_ITERATIONS, maxCaptureAllocations);
+    append("Lines over %i KiB: %u formatted, %u truncated\r\n",
+           SOAK_HUGE_NAME_SIZE / 1024, soak.hugeLines, soak.truncations);
+    append("Private memory: %lu KiB after warm-up, %lu KiB at end, %lu KiB peak working set\r\n",
+           (unsigned long) (warmMemory / 1024),
+           (unsigned long) (finalMemory / 1024),
+           (unsigned long) (peakMemory / 1024));
+
+    memset(&soak, 0, sizeof(soak));
+
+    if (failure)
+    {
+        append("Soak test failed: %s\r\n", failure);
+        result = 0;
+    }
+    else
+        append("Soak test passed\r\n");
+
+    return result;
+}
+
+char* record_capture(void)
+{
+    GLFWwindow* window;
+    const report_buffer saved = report;
+
+    clear_capture();
+
+    glfwDefaultWindowHints();
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+
+    window = glfwCreateWindow(640, 480, "Capture", NULL, NULL);
+    if (window)
+        glfwMakeContextCurrent(window);
+
+    // The report text itself is not needed, only the recorded answers
+    memset(&report, 0, sizeof(report));
+
+    backend = &record_backend;
+    build_report();
+    backend = &live_backend;
+
+    free(report.text);
+    report = saved;
+
+    if (window)
+        glfwDestroyWindow(window);
+
+    return serialize_capture();
+}
+
+int replay_capture(const char* text)
+{
+    if (!parse_capture(text))
+    {
+        append_separator();
+        append("Failed to parse capture\r\n");
+        return 0;
+    }
+
+    report.length = 0;
+    if (report.text)
+        report.text[0] = '\0';
+
+    backend = &replay_backend;
+    build_report();
+    backend = &live_backend;
+
+    return 1;
+}
+
+int test_replay_benchmark(void)
+{
+    int i;
+    double base, elapsed;
+    size_t length;
+    const report_buffer saved = report;
+
+    append_separator();
+
+    if (is_capture_empty())
+    {
+        append("No capture has been recorded or opened\r\n");
+        return 0;
+    }
+
+    memset(&report, 0, sizeof(report));
+    backend = &replay_backend;
+
+    base = glfwGetTime();
+
+    for (i = 0;  i < REPLAY_ITERATIONS;  i++)
+    {
+        report.length = 0;
+        build_report();
+    }
+
+    elapsed = glfwGetTime() - base;
+    length = report.length;
+
+    backend = &live_backend;
+    free(report.text);
+    report = saved;
+
+    append("Building a %lu byte report from the capture took %0.3f us\r\n",
+           (unsigned long) length,
+           elapsed * 1000000.0 / REPLAY_ITERATIONS);
+
+    return 1;
+}
+
+int test_pixel_readback(void)
+{
+    int i, result = 1;
+    double base;
+    size_t mismatches = 0;
+    GLFWwindow* window;
+
+    append_separator();
+    append("Probing pixel readback\r\n");
+
+    memset(&readback, 0, sizeof(readback));
+
+    glfwDefaultWindowHints();
+    glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+    glfwWindowHint(GLFW_RED_BITS, 8);
+    glfwWindowHint(GLFW_GREEN_BITS, 8);
+    glfwWindowHint(GLFW_BLUE_BITS, 8);
+    glfwWindowHint(GLFW_ALPHA_BITS, 8);
+
+    window = glfwCreateWindow(READBACK_WIDTH, READBACK_HEIGHT,
+                              "Pixel Readback", NULL, NULL);
+    if (!window)
+        return 0;
+
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+
+    // The hints are only a request, so compare at the depth we were granted
+    set_readback_tolerance();
+
+    // The pattern is split into quadrants so the size must be even
+    glfwGetFramebufferSize(window, &readback.width, &readback.height);
+    readback.width &= ~1;
+    readback.height &= ~1;
+    readback.size = (size_t) readback.width * readback.height * 4;
+
+    if (!readback.size)
+    {
+        append("Framebuffer is empty\r\n");
+        glfwDestroyWindow(window);
+        return 0;
+    }
+
+    readback.pixels = malloc(readback.size);
+    for (i = 0;  i < READBACK_PATTERNS;  i++)
+    {
+        readback.expected[i] = malloc(readback.size);
+        if (readback.expected[i])
+            generate_readback_pattern(readback.expected[i], i);
+        else
+            result = 0;
+    }
+
+    if (result && readback.pixels)
+    {
+        glDisable(GL_DITHER);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+        append("Reading %i x %i RGBA pixels for %i frames\r\n",
+               readback.width, readback.height, READBACK_FRAMES);
+        append("Framebuffer has R%i G%i B%i A%i bits, tolerance %i %i %i %i\r\n",
+               readback.bits[0], readback.bits[1],
+               readback.bits[2], readback.bits[3],
+               readback.tolerance[0], readback.tolerance[1],
+               readback.tolerance[2], readback.tolerance[3]);
+
+        // Compare adjacent patterns so every frame has work to do, and print
+        // the total so the compiler cannot discard the loop
+        base = glfwGetTime();
+
+        for (i = 0;  i < READBACK_FRAMES;  i++)
+        {
+            mismatches += count_mismatches(readback.expected[i % READBACK_PATTERNS],
+                                           readback.expected[(i + 1) % READBACK_PATTERNS],
+                                           readback.size);
+        }
+
+        append("Comparing a frame took %0.3f ms (%s, %lu bytes differed)\r\n",
+               (glfwGetTime() - base) * 1000.0 / READBACK_FRAMES,
+               COMPARE_NAME,
+               (unsigned long) mismatches);
+
+        run_sync_readback(window);
+
+        if (load_readback_functions(window))
+        {
+            for (i = 1;  i <= READBACK_MAX_BUFFERS;  i++)
+                run_pbo_readback(window, i);
+        }
+        else
+            append("Pixel buffer objects are not available\r\n");
+    }
+    else
+    {
+        append("Failed to allocate readback buffers\r\n");
+        result = 0;
+    }
+
+    free(readback.pixels);
+    for (i = 0;  i < READBACK_PATTERNS;  i++)
+        free(readback.expected[i]);
+
+    memset(&readback, 0, sizeof(readback));
+
+    glfwDestroyWindow(window);
+    return result;
+}
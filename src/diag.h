@@ -28,11 +28,24 @@ extern int report_init(void);
 extern void report_terminate(void);
 
 extern void report_monitors(void);
+extern void report_gamma_ramps(void);
 extern void report_joysticks(void);
 extern void report_context(void);
 extern void report_extensions(void);
 
 extern char* get_report(void);
 
+extern char* record_capture(void);
+extern int replay_capture(const char* text);
+
 extern int test_default_window(void);
+extern int test_event_loop(void);
+extern int test_window_resize(void);
+extern int test_report_soak(void);
+extern int test_replay_benchmark(void);
+extern int test_pixel_readback(void);
+
+// Implemented by the platform frontend
+extern void get_memory_usage(size_t* committed, size_t* peak);
+extern void show_progress(const char* task, int percent);
 
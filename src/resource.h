@@ -9,4 +9,12 @@
 #define IDM_COPY            123
 #define IDM_SELECTALL       124
 #define IDM_DEFAULTWINDOW   125
+#define IDM_GAMMARAMPS      126
+#define IDM_EVENTLOOP       127
+#define IDM_RESIZESTRESS    128
+#define IDM_REPORTSOAK      129
+#define IDM_OPENCAPTURE     130
+#define IDM_SAVECAPTURE     131
+#define IDM_REPLAYBENCHMARK 132
+#define IDM_PIXELREADBACK   133
 
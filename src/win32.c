@@ -30,6 +30,8 @@
 
 #include <windows.h>
 #include <windowsx.h>
+#include <psapi.h>
+#include <shellapi.h>
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -38,6 +40,11 @@
 #include "resource.h"
 
 #define MAIN_WCL_NAME L"GLFWDIAG"
+#define MAIN_WINDOW_TITLE L"GLFW Diagnostics Tool"
+
+#define CAPTURE_FILTER L"Capture Files (*.capture)\0*.capture\0" \
+                       L"All Files (*.*)\0*.*\0" \
+                       L"\0"
 
 static struct
 {
@@ -107,6 +114,120 @@ static char* get_window_text_utf8(HWND window)
     return text;
 }
 
+void get_memory_usage(size_t* committed, size_t* peak)
+{
+    // The working set is trimmed by Windows at will, so growth is judged on
+    // committed private memory and the working set only reports the peak
+    PROCESS_MEMORY_COUNTERS_EX pmc;
+    ZeroMemory(&pmc, sizeof(pmc));
+
+    if (!GetProcessMemoryInfo(GetCurrentProcess(),
+                              (PROCESS_MEMORY_COUNTERS*) &pmc,
+                              sizeof(pmc)))
+    {
+        *committed = *peak = 0;
+        return;
+    }
+
+    *committed = pmc.PrivateUsage;
+    *peak = pmc.PeakWorkingSetSize;
+}
+
+static BOOL get_capture_path(WCHAR* path, DWORD size, BOOL save)
+{
+    OPENFILENAME ofn;
+    ZeroMemory(&ofn, sizeof(ofn));
+
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = state.window;
+    ofn.hInstance = state.instance;
+    ofn.lpstrFilter = CAPTURE_FILTER;
+    ofn.nFilterIndex = 1;
+    ofn.lpstrFile = path;
+    ofn.nMaxFile = size;
+    ofn.lpstrDefExt = L"capture";
+
+    wcscpy(path, L"GLFWDIAG.capture");
+
+    if (save)
+    {
+        ofn.Flags = OFN_OVERWRITEPROMPT | OFN_HIDEREADONLY;
+        return GetSaveFileName(&ofn);
+    }
+    else
+    {
+        ofn.Flags = OFN_FILEMUSTEXIST | OFN_HIDEREADONLY;
+        return GetOpenFileName(&ofn);
+    }
+}
+
+static char* read_file(const WCHAR* path)
+{
+    long size;
+    char* text;
+    FILE* file = _wfopen(path, L"rb");
+
+    if (!file)
+        return NULL;
+
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    if (size < 0)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    text = malloc(size + 1);
+    if (text)
+        text[fread(text, 1, size, file)] = '\0';
+
+    fclose(file);
+    return text;
+}
+
+void show_progress(const char* task, int percent)
+{
+    MSG msg;
+
+    if (!state.window)
+        return;
+
+    if (task)
+    {
+        WCHAR title[256];
+        WCHAR* wideTask = utf16_from_utf8(task);
+
+        if (wideTask)
+        {
+            _snwprintf(title, sizeof(title) / sizeof(WCHAR),
+                       MAIN_WINDOW_TITLE L" - %s %i%%", wideTask, percent);
+            title[sizeof(title) / sizeof(WCHAR) - 1] = L'\0';
+
+            SetWindowText(state.window, title);
+            free(wideTask);
+        }
+    }
+    else
+        SetWindowText(state.window, MAIN_WINDOW_TITLE);
+
+    // The main window is disabled while a long task runs, so this only
+    // repaints and keeps Windows from flagging us as not responding
+    while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+    {
+        if (msg.message == WM_QUIT)
+        {
+            PostQuitMessage((int) msg.wParam);
+            break;
+        }
+
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+}
+
 static void update_report(void)
 {
     WCHAR* report;
@@ -163,6 +284,47 @@ static void handle_menu_command(int command)
             break;
         }
 
+        case IDM_OPENCAPTURE:
+        {
+            WCHAR path[MAX_PATH + 1];
+
+            if (get_capture_path(path, sizeof(path) / sizeof(WCHAR), FALSE))
+            {
+                char* text = read_file(path);
+                if (text)
+                {
+                    replay_capture(text);
+                    update_report();
+                    free(text);
+                }
+            }
+
+            break;
+        }
+
+        case IDM_SAVECAPTURE:
+        {
+            WCHAR path[MAX_PATH + 1];
+
+            if (get_capture_path(path, sizeof(path) / sizeof(WCHAR), TRUE))
+            {
+                char* text = record_capture();
+                if (text)
+                {
+                    FILE* file = _wfopen(path, L"wb");
+                    if (file)
+                    {
+                        fwrite(text, 1, strlen(text), file);
+                        fclose(file);
+                    }
+
+                    free(text);
+                }
+            }
+
+            break;
+        }
+
         case IDM_COPY:
         {
             SendMessage(state.edit, WM_COPY, 0, 0);
@@ -186,6 +348,70 @@ static void handle_menu_command(int command)
             break;
         }
 
+        case IDM_EVENTLOOP:
+        {
+            ShowWindow(state.window, SW_HIDE);
+
+            test_event_loop();
+            update_report();
+
+            ShowWindow(state.window, SW_SHOWNORMAL);
+            break;
+        }
+
+        case IDM_RESIZESTRESS:
+        {
+            ShowWindow(state.window, SW_HIDE);
+
+            test_window_resize();
+            update_report();
+
+            ShowWindow(state.window, SW_SHOWNORMAL);
+            break;
+        }
+
+        case IDM_PIXELREADBACK:
+        {
+            ShowWindow(state.window, SW_HIDE);
+
+            test_pixel_readback();
+            update_report();
+
+            ShowWindow(state.window, SW_SHOWNORMAL);
+            break;
+        }
+
+        case IDM_REPORTSOAK:
+        {
+            HCURSOR cursor = SetCursor(LoadCursor(NULL, IDC_WAIT));
+            EnableWindow(state.window, FALSE);
+
+            test_report_soak();
+            update_report();
+
+            EnableWindow(state.window, TRUE);
+            SetCursor(cursor);
+            break;
+        }
+
+        case IDM_REPLAYBENCHMARK:
+        {
+            HCURSOR cursor = SetCursor(LoadCursor(NULL, IDC_WAIT));
+
+            test_replay_benchmark();
+            update_report();
+
+            SetCursor(cursor);
+            break;
+        }
+
+        case IDM_GAMMARAMPS:
+        {
+            report_gamma_ramps();
+            update_report();
+            break;
+        }
+
         case IDM_EXIT:
         {
             DestroyWindow(state.window);
@@ -247,7 +473,7 @@ static int create_main_window(int show)
 
     state.window = CreateWindowEx(WS_EX_APPWINDOW,
                                   MAIN_WCL_NAME,
-                                  L"GLFW Diagnostics Tool",
+                                  MAIN_WINDOW_TITLE,
                                   WS_OVERLAPPEDWINDOW,
                                   CW_USEDEFAULT, 0,
                                   CW_USEDEFAULT, 0,
@@ -289,12 +515,133 @@ static int create_main_window(int show)
     return TRUE;
 }
 
+static BOOL write_output(const WCHAR* path, const char* text)
+{
+    DWORD written;
+    HANDLE output;
+
+    if (path)
+    {
+        size_t length;
+        FILE* file = _wfopen(path, L"wb");
+
+        if (!file)
+            return FALSE;
+
+        length = fwrite(text, 1, strlen(text), file);
+        fclose(file);
+
+        return length == strlen(text);
+    }
+
+    // We are a GUI subsystem program, so unless our output was redirected
+    // we have to borrow the console of whoever started us
+    output = GetStdHandle(STD_OUTPUT_HANDLE);
+    if (!output || output == INVALID_HANDLE_VALUE)
+    {
+        if (!AttachConsole(ATTACH_PARENT_PROCESS))
+            return FALSE;
+
+        output = GetStdHandle(STD_OUTPUT_HANDLE);
+        if (!output || output == INVALID_HANDLE_VALUE)
+            return FALSE;
+    }
+
+    return WriteFile(output, text, (DWORD) strlen(text), &written, NULL);
+}
+
+static BOOL is_command_line_option(const WCHAR* argument)
+{
+    return lstrcmpW(argument, L"--replay-benchmark") == 0 ||
+           lstrcmpW(argument, L"--output") == 0 ||
+           lstrcmpW(argument, L"--soak") == 0;
+}
+
+// Runs the tests named on the command line without creating any windows
+// Returns -1 if no option was given, for example when a file was dropped
+// onto the executable, otherwise the process exit code
+//
+static int run_command_line(void)
+{
+    int i, argc, result = EXIT_SUCCESS;
+    const WCHAR* capturePath = NULL;
+    const WCHAR* outputPath = NULL;
+    BOOL soak = FALSE;
+    WCHAR** argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+
+    if (!argv)
+        return -1;
+
+    for (i = 1;  i < argc;  i++)
+    {
+        if (is_command_line_option(argv[i]))
+            break;
+    }
+
+    if (i == argc)
+    {
+        LocalFree(argv);
+        return -1;
+    }
+
+    for (i = 1;  i < argc;  i++)
+    {
+        if (lstrcmpW(argv[i], L"--replay-benchmark") == 0 && i + 1 < argc)
+            capturePath = argv[++i];
+        else if (lstrcmpW(argv[i], L"--output") == 0 && i + 1 < argc)
+            outputPath = argv[++i];
+        else if (lstrcmpW(argv[i], L"--soak") == 0)
+            soak = TRUE;
+        else
+        {
+            capturePath = NULL;
+            soak = FALSE;
+            break;
+        }
+    }
+
+    if (!capturePath && !soak)
+    {
+        write_output(outputPath,
+                     "Usage: glfwdiag [--replay-benchmark <capture>] [--soak] "
+                     "[--output <file>]\r\n");
+        LocalFree(argv);
+        return EXIT_FAILURE;
+    }
+
+    if (capturePath)
+    {
+        char* text = read_file(capturePath);
+        if (!text)
+        {
+            write_output(outputPath, "Failed to read capture file\r\n");
+            LocalFree(argv);
+            return EXIT_FAILURE;
+        }
+
+        if (!replay_capture(text) || !test_replay_benchmark())
+            result = EXIT_FAILURE;
+
+        free(text);
+    }
+
+    if (soak && !test_report_soak())
+        result = EXIT_FAILURE;
+
+    if (!write_output(outputPath, get_report()))
+        result = EXIT_FAILURE;
+
+    LocalFree(argv);
+    return result;
+}
+
 int APIENTRY WinMain(HINSTANCE instance,
                      HINSTANCE previous,
                      LPSTR commandLine,
                      int show)
 {
     MSG msg;
+    int exitCode;
 
     UNREFERENCED_PARAMETER(previous);
     UNREFERENCED_PARAMETER(commandLine);
@@ -305,6 +652,13 @@ int APIENTRY WinMain(HINSTANCE instance,
     if (!report_init())
         error();
 
+    exitCode = run_command_line();
+    if (exitCode != -1)
+    {
+        report_terminate();
+        exit(exitCode);
+    }
+
     if (!register_main_class())
         error();
 